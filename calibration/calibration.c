@@ -16,11 +16,13 @@
  */
 
 #include <math.h>
+#include <string.h>
 
 #include <chimaera.h>
 #include <debug.h>
 #include <eeprom.h>
 #include <linalg.h>
+#include <sensors.h>
 #include "../cmc/cmc_private.h"
 
 #include "calibration_private.h"
@@ -29,12 +31,32 @@
 Calibration range;
 uint_fast8_t zeroing = 0;
 uint_fast8_t calibrating = 0;
-float curve [0x800];
+Curve_Segment curve [CURVE_N + 1];
+Tuning tune;
+uint_fast8_t tuning = 0;
+uint8_t tune_smpr = 6; // 181.5 cycles
+uint8_t tune_settle = 0;
 
 // when calibrating, we use the curve buffer as temporary memory, it's big enough and not used during calibration
 static Calibration_Array *arr =(Calibration_Array *)curve;
 static Calibration_Point point;
 
+// the same holds for tuning
+static Tuning_Array *tarr =(Tuning_Array *)curve;
+static uint_fast8_t tune_k; // setting under test, TUNE_N for the final pass with the selected one
+static uint_fast8_t tune_frame;
+static uint8_t tune_noise [SENSOR_N]; // per-sensor RMS noise of selected setting in 1/16 LSB
+static uint8_t tune_crosstalk [SENSOR_N]; // per-sensor deviation of selected setting in 1/16 LSB
+
+static const uint16_t tune_cycles2 [TUNE_SMPR_N] = {3, 5, 9, 15, 39, 123, 363, 1203}; // sample times in half ADC cycles
+static const uint8_t tune_settles [TUNE_SETTLE_N] = {8, 2, 0}; // us
+
+#define TUNE_SKIP 2 // frames discarded after switching settings
+#define TUNE_FRAMES 64 // frames accumulated per setting
+
+_Static_assert(sizeof(Tuning_Array) <= sizeof(curve), "curve buffer too small for tuning");
+_Static_assert(EEPROM_TUNE_OFFSET + sizeof(Tuning) <= EEPROM_SIZE, "EEPROM too small for tuning");
+
 static float
 _as(uint16_t qui, uint16_t out_s, uint16_t out_n, uint16_t b)
 {
@@ -92,49 +114,185 @@ range_save(uint_fast8_t pos)
 	return 1;
 }
 
-void
-range_curve_update(void)
+uint_fast8_t
+tune_load(void)
 {
-	uint32_t i;
+	eeprom_bulk_read(eeprom_24LC64, EEPROM_TUNE_OFFSET,(uint8_t *)&tune, sizeof(tune));
 
-	for(i=0; i<0x800; i++)
+	if( (tune.smpr >= TUNE_SMPR_N) || (tune.settle > tune_settles[0]) ) // never tuned, fall back to factory settings
 	{
-		float x =(float)i /(float)0x7ff;
-		float y = range.C[0]*cbrtf(x) + range.C[1]*sqrtf(x) + range.C[2]*x;
-		y = y < 0.f ? 0.f :(y > 1.f ? 1.f : y);
-		curve[i] = y;
+		memset(&tune, 0, sizeof(tune));
+		tune.smpr = 6; // 181.5 cycles
+		tune.settle = 0;
+		tune.bound = 3 << 4; // 3 LSB
 	}
+
+	tune_smpr = tune.smpr;
+	tune_settle = tune.settle;
+
+	return 1;
 }
 
+uint_fast8_t
+tune_save(void)
+{
+	eeprom_bulk_write(eeprom_24LC64, EEPROM_TUNE_OFFSET,(uint8_t *)&tune, sizeof(tune));
+
+	return 1;
+}
+
+static void
+_tune_setting(uint_fast8_t k)
+{
+	tune_smpr = TUNE_SMPR_N-1 - k/TUNE_SETTLE_N;
+	tune_settle = tune_settles[k % TUNE_SETTLE_N];
+}
+
+// duration of a mux step in ns: settle delay plus conversion of the longer sequence at 72MHz
+static uint32_t
+_tune_step_ns(uint_fast8_t k)
+{
+	const uint32_t conv = ADC_DUAL_LENGTH > ADC_SING_LENGTH ? ADC_DUAL_LENGTH : ADC_SING_LENGTH;
+
+	return tune_settles[k % TUNE_SETTLE_N]*1000
+		+ conv*(tune_cycles2[TUNE_SMPR_N-1 - k/TUNE_SETTLE_N] + 25)*1000 / 144;
+}
+
+// shortest setting within the bound, the most conservative one when none qualifies
+static uint_fast8_t
+_tune_select(void)
+{
+	uint_fast8_t k;
+	uint_fast8_t best = 0;
+
+	for(k=1; k<TUNE_N; k++)
+		if( (tune.noise[k] <= tune.bound) && (tune.crosstalk[k] <= tune.bound)
+				&& (_tune_step_ns(k) < _tune_step_ns(best)) )
+			best = k;
+
+	return best;
+}
+
+static inline uint16_t
+_tune_q16(float v)
+{
+	v *= 16.f;
+	return v < 0xffff ? v : 0xffff;
+}
+
+// sweep the settings against the quiescent state, called once per frame while tuning
 void
-range_calibrate(int16_t *raw12, int16_t *raw3, uint8_t *order12, uint8_t *order3, int16_t *sum, int16_t *rela)
+tune_process(int16_t *rela)
 {
-	(void)sum;
 	uint_fast8_t i;
-	uint_fast8_t pos;
-	
-	// fill rela vector from raw vector
-#if(ADC_DUAL_LENGTH > 0)
-	for(i=0; i<MUX_MAX*ADC_DUAL_LENGTH*2; i++)
+
+	if(tune_frame < TUNE_SKIP) // acquired with previous setting
 	{
-		pos = order12[i];
-		rela[pos] = raw12[i];
+		if(++tune_frame == TUNE_SKIP)
+		{
+			memset(tarr->sum, 0, sizeof(tarr->sum));
+			memset(tarr->sum2, 0, sizeof(tarr->sum2));
+		}
+		return;
+	}
+
+	for(i=0; i<SENSOR_N; i++)
+	{
+		uint32_t v = rela[i];
+		tarr->sum[i] += v;
+		tarr->sum2[i] += (uint64_t)v*v;
+	}
+
+	if(++tune_frame < TUNE_SKIP + TUNE_FRAMES)
+		return;
+
+	// evaluate setting
+	float noise_max = 0.f;
+	float crosstalk_max = 0.f;
+	for(i=0; i<SENSOR_N; i++)
+	{
+		float mean =(float)tarr->sum[i] / TUNE_FRAMES;
+		int64_t var_n2 =(int64_t)(TUNE_FRAMES*tarr->sum2[i]) - (int64_t)tarr->sum[i]*tarr->sum[i]; // exact, float would cancel
+		float noise = var_n2 > 0 ? sqrtf((float)var_n2) / TUNE_FRAMES : 0.f;
+
+		if(tune_k == 0) // reference for crosstalk
+			tarr->ref[i] = mean;
+		float crosstalk = fabsf(mean - tarr->ref[i]);
+
+		if(noise > noise_max)
+			noise_max = noise;
+		if(crosstalk > crosstalk_max)
+			crosstalk_max = crosstalk;
+
+		if(tune_k == TUNE_N)
+		{
+			uint16_t q;
+			q = _tune_q16(noise);
+			tune_noise[i] = q < 0xff ? q : 0xff;
+			q = _tune_q16(crosstalk);
+			tune_crosstalk[i] = q < 0xff ? q : 0xff;
+		}
 	}
-#else
-	(void)raw12;
-	(void)order12;
-#endif
 
-#if(ADC_SING_LENGTH > 0)
-	for(i=0; i<MUX_MAX*ADC_SING_LENGTH; i++)
+	tune_frame = 0;
+
+	if(tune_k < TUNE_N)
 	{
-		pos = order3[i];
-		rela[pos] = raw3[i];
+		tune.noise[tune_k] = _tune_q16(noise_max);
+		tune.crosstalk[tune_k] = _tune_q16(crosstalk_max);
+
+		if(++tune_k < TUNE_N)
+			_tune_setting(tune_k);
+		else // final pass with selected setting
+		{
+			uint_fast8_t k = _tune_select();
+			tune.smpr = TUNE_SMPR_N-1 - k/TUNE_SETTLE_N;
+			tune.settle = tune_settles[k % TUNE_SETTLE_N];
+			_tune_setting(k);
+		}
 	}
-#else
-	(void)raw3;
-	(void)order3;
-#endif
+	else // done
+	{
+		tuning = 0;
+		range_curve_update(); // curve buffer was used as temporary memory
+	}
+}
+
+static inline float
+_curve(float x)
+{
+	float y = range.C[0]*cbrtf(x) + range.C[1]*sqrtf(x) + range.C[2]*x;
+	return y < 0.f ? 0.f :(y > 1.f ? 1.f : y);
+}
+
+void
+range_curve_update(void)
+{
+	uint32_t i;
+	float y0 = _curve(0.f);
+
+	for(i=0; i<CURVE_N; i++)
+	{
+		float x0 =(float)i /(float)CURVE_N;
+		float x1 =(float)(i+1) /(float)CURVE_N;
+		float y1 = _curve(x1);
+
+		// y = a + b*x on [x0, x1)
+		curve[i].b =(y1 - y0) * CURVE_N;
+		curve[i].a = y0 - curve[i].b*x0;
+
+		y0 = y1;
+	}
+
+	// y == 1.f lands here
+	curve[CURVE_N].a = y0;
+	curve[CURVE_N].b = 0.f;
+}
+
+void
+range_calibrate(int16_t *rela)
+{
+	uint_fast8_t i;
 
 	// do the calibration
 	for(i=0; i<SENSOR_N; i++)
@@ -404,13 +562,19 @@ _calibration_start(const char *path, const char *fmt, uint_fast8_t argc, osc_dat
 
 	buf_ptr = osc_get_int32(buf_ptr, &uuid);
 
-	range_init();
+	if(!tuning) // both need the curve buffer
+	{
+		range_init();
 
-	// enable calibration
-	zeroing = 1;
-	calibrating = 1;
+		// enable calibration
+		zeroing = 1;
+		calibrating = 1;
+
+		size = CONFIG_SUCCESS("is", uuid, path);
+	}
+	else
+		size = CONFIG_FAIL("iss", uuid, path, "tuning in progress");
 
-	size = CONFIG_SUCCESS("is", uuid, path);
 	CONFIG_SEND(size);
 
 	return 1;
@@ -714,6 +878,7 @@ _calibration_save(const char *path, const char *fmt, uint_fast8_t argc, osc_data
 	buf_ptr = osc_get_int32(buf_ptr, &uuid);
 	buf_ptr = osc_get_int32(buf_ptr, &pos);
 
+	sensors_health_restore(); // store calibrated thresholds, not the noise-fed ones
 	range_save(pos);
 	size = CONFIG_SUCCESS("is", uuid, path);
 	CONFIG_SEND(size);
@@ -761,6 +926,226 @@ _calibration_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_dat
 	return 1;
 }
 
+static uint_fast8_t
+_tune_start(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(!calibrating && !tuning) // both need the curve buffer
+	{
+		tune_k = 0;
+		tune_frame = 0;
+		_tune_setting(0);
+		tuning = 1;
+
+		size = CONFIG_SUCCESS("is", uuid, path);
+	}
+	else
+		size = CONFIG_FAIL("iss", uuid, path, "calibration or tuning in progress");
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_tune_busy(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	size = CONFIG_SUCCESS("isi", uuid, path, tuning ? 1 : 0);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_tune_bound(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isf", uuid, path, tune.bound / 16.f);
+	else
+	{
+		float f;
+		buf_ptr = osc_get_float(buf_ptr, &f);
+		if( (f > 0.f) && (f < 0x1000) )
+		{
+			tune.bound = f * 16.f;
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "valid bounds are in (0, 4096) LSB");
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_tune_sample_time(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	size = CONFIG_SUCCESS("isf", uuid, path, tune_cycles2[tune.smpr] / 2.f);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_tune_settle(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	size = CONFIG_SUCCESS("isi", uuid, path, tune.settle);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+// get tuning data per sensor of selected setting
+static uint_fast8_t
+_tune_noise(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	uint8_t *noise = NULL;
+	size = CONFIG_SUCCESS("isB", uuid, path, sizeof(tune_noise), &noise);
+	memcpy(noise, tune_noise, sizeof(tune_noise));
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_tune_crosstalk(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	uint8_t *crosstalk = NULL;
+	size = CONFIG_SUCCESS("isB", uuid, path, sizeof(tune_crosstalk), &crosstalk);
+	memcpy(crosstalk, tune_crosstalk, sizeof(tune_crosstalk));
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+// get worst noise and crosstalk of all tested settings, interleaved
+static uint_fast8_t
+_tune_settings(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	uint16_t *settings = NULL;
+	size = CONFIG_SUCCESS("isB", uuid, path, sizeof(tune.noise) + sizeof(tune.crosstalk), &settings);
+
+	// hton
+	uint_fast8_t k;
+	for(k=0; k<TUNE_N; k++)
+	{
+		settings[2*k] = hton(tune.noise[k]);
+		settings[2*k+1] = hton(tune.crosstalk[k]);
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_tune_save(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	tune_save();
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_tune_load(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(!tuning)
+	{
+		tune_load();
+		size = CONFIG_SUCCESS("is", uuid, path);
+	}
+	else
+		size = CONFIG_FAIL("iss", uuid, path, "tuning in progress");
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
 /*
  * Query
  */
@@ -797,6 +1182,37 @@ static const OSC_Query_Argument calibration_curve_args [] = {
 	OSC_QUERY_ARGUMENT_FLOAT("ci", OSC_QUERY_MODE_R, -100.f, 100.f, 0.f)
 };
 
+static const OSC_Query_Argument tune_busy_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_R)
+};
+
+static const OSC_Query_Argument tune_bound_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("LSB", OSC_QUERY_MODE_RW, 0.f, 4096.f, 0.0625f)
+};
+
+static const OSC_Query_Argument tune_sample_time_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Cycles", OSC_QUERY_MODE_R, 1.5f, 601.5f, 0.f)
+};
+
+static const OSC_Query_Argument tune_settle_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("us", OSC_QUERY_MODE_R, 0, 8, 1)
+};
+
+static const OSC_Query_Item tune_tree [] = {
+	OSC_QUERY_ITEM_METHOD("load", "Load tuning from EEPROM", _tune_load, NULL),
+	OSC_QUERY_ITEM_METHOD("save", "Save tuning to EEPROM", _tune_save, NULL),
+
+	OSC_QUERY_ITEM_METHOD("start", "Start self-test against quiescent state", _tune_start, NULL),
+	OSC_QUERY_ITEM_METHOD("busy", "Self-test in progress", _tune_busy, tune_busy_args),
+	OSC_QUERY_ITEM_METHOD("bound", "Noise and crosstalk bound", _tune_bound, tune_bound_args),
+
+	OSC_QUERY_ITEM_METHOD("sample_time", "Selected ADC sample time", _tune_sample_time, tune_sample_time_args),
+	OSC_QUERY_ITEM_METHOD("settle", "Selected mux settle delay", _tune_settle, tune_settle_args),
+	OSC_QUERY_ITEM_METHOD("noise", "Query RMS noise in 1/16 LSB", _tune_noise, calibration_blob_args),
+	OSC_QUERY_ITEM_METHOD("crosstalk", "Query crosstalk in 1/16 LSB", _tune_crosstalk, calibration_blob_args),
+	OSC_QUERY_ITEM_METHOD("settings", "Query worst noise and crosstalk of tested settings", _tune_settings, calibration_blob_args)
+};
+
 const OSC_Query_Item calibration_tree [] = {
 	OSC_QUERY_ITEM_METHOD("load", "Load calibration from EEPROM", _calibration_load, calibration_load_args),
 	OSC_QUERY_ITEM_METHOD("save", "Save calibration to EEPROM", _calibration_save, calibration_save_args),
@@ -816,5 +1232,7 @@ const OSC_Query_Item calibration_tree [] = {
 	OSC_QUERY_ITEM_METHOD("W", "Query array calibration offset data", _calibration_offset, calibration_offset_args),
 	OSC_QUERY_ITEM_METHOD("c0", "Query curve-fit parameter 0", _calibration_curve_c0, calibration_curve_args),
 	OSC_QUERY_ITEM_METHOD("c1", "Query curve-fit parameter 1", _calibration_curve_c1, calibration_curve_args),
-	OSC_QUERY_ITEM_METHOD("c2", "Query curve-fit parameter 2", _calibration_curve_c2, calibration_curve_args)
+	OSC_QUERY_ITEM_METHOD("c2", "Query curve-fit parameter 2", _calibration_curve_c2, calibration_curve_args),
+
+	OSC_QUERY_ITEM_NODE("tune/", "ADC sample time and mux settle self-test", tune_tree)
 };
@@ -22,11 +22,18 @@
 
 typedef struct _Calibration_Array Calibration_Array;
 typedef struct _Calibration_Point Calibration_Point;
+typedef struct _Tuning_Array Tuning_Array;
 
 struct _Calibration_Array {
 	uint16_t arr [2][SENSOR_N];
 };
 
+struct _Tuning_Array {
+	uint32_t sum [SENSOR_N];
+	uint64_t sum2 [SENSOR_N];
+	float ref [SENSOR_N]; // mean values of the most conservative setting
+};
+
 struct _Calibration_Point {
 	uint_fast8_t i;
 	uint_fast8_t state;
@@ -23,3 +23,10 @@ const uint_fast8_t buf_i_ptr = 0;
 // the buffers should be aligned to 32bit, as most we write to it is a multiple of 32bit(OSC, SNTP, DHCP, ARP, etc.)
 uint8_t buf_o [2][CHIMAERA_BUFSIZE] __attribute__((aligned(4))); // general purpose output buffer
 uint8_t buf_i [1][CHIMAERA_BUFSIZE] __attribute__((aligned(4))); // general purpose input buffer;
+uint8_t buf_f [OUTPUT_FANOUT_MAX][CHIMAERA_BUFSIZE] __attribute__((aligned(4))); // fan-out output buffers
+
+#define SRAM_SIZE 0xa000 // 40 KB of the STM32F303Cx
+
+// leave at least half of SRAM to the curve lookup table, sensor pipeline, config and stack
+_Static_assert(sizeof(buf_o) + sizeof(buf_i) + sizeof(buf_f) <= SRAM_SIZE/2,
+	"network buffers too large for SRAM, lower BLOBS or FANOUT");
@@ -27,6 +27,7 @@
 #include <config.h>
 #include <calibration.h>
 #include <sensors.h>
+#include <wiz.h>
 
 // engines
 #include <tuio2.h>
@@ -38,7 +39,16 @@
 
 // globals
 CMC_Engine *engines [ENGINE_MAX+1];
+static const uint8_t *engines_deltas [ENGINE_MAX]; // per-engine suppression of still blob updates
+static const uint8_t *engines_decimation [ENGINE_MAX]; // per-engine update divider
+static uint8_t engines_dest [ENGINE_MAX]; // per-engine destination, 0: output socket
+static uint16_t engines_head [ENGINE_MAX]; // high-water marks of serialized frame_cb, starting at the static budgets
+static uint16_t engines_blob [ENGINE_MAX]; // ^per-blob
+static uint16_t engines_tail [ENGINE_MAX]; // ^and end_cb sizes
 uint_fast8_t cmc_engines_active = 0;
+uint8_t cmc_dest_engines [OUTPUT_FANOUT_MAX+1];
+CMC_Output cmc_fanout [OUTPUT_FANOUT_MAX]; // filled in by caller for destinations with engines
+CMC_Flush_Cb cmc_flush_cb = NULL;
 CMC_Group *cmc_groups = config.groups;
 uint16_t cmc_groups_n = GROUP_MAX;
 
@@ -46,12 +56,38 @@ uint16_t cmc_groups_n = GROUP_MAX;
 Stop_Watch sw_engine_process = {.id = "engine_process", .thresh=3000};
 #endif
 
+#ifdef BENCHMARK_INTERPOLATION
+uint64_t cmc_interpolation_cycles = 0;
+uint32_t cmc_interpolation_peaks = 0;
+#	if defined(__arm__)
+#		define DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#		define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#		define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#		define CYCLES() DWT_CYCCNT
+#	elif defined(__x86_64__) || defined(__i386__)
+#		include <x86intrin.h>
+#		define CYCLES() __rdtsc()
+#	else
+#		include <time.h>
+static inline uint64_t
+CYCLES(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec; // nanoseconds
+}
+#	endif
+#endif
+
 // locals
 static uint16_t idle_word = 0;
 static uint8_t idle_bit = 0;
 
 static uint_fast8_t n_aoi;
-static uint8_t aoi[BLOB_MAX*13]; //TODO how big? BLOB_MAX * 5,7,9 ?
+static uint8_t aoi[SENSOR_N]; // every sensor is listed at most once
+
+static CMC_Mask aoi_mask; // candidate sensors of current cycle, when not provided by adc_fill
+static uint32_t aoi_prev[CMC_MASK_N]; // candidate sensors of previous cycle
 
 static uint_fast8_t n_peaks;
 static uint8_t peaks[BLOB_MAX];
@@ -67,6 +103,10 @@ static uint32_t fid, sid;
 static float d, d_2;
 
 static float s, sm1; // filter stiffness, (1-stiffness)
+static float g, h, k; // fading-memory gains of position, velocity and acceleration
+static uint_fast8_t predict; // extrapolate blobs to output offset
+
+static CMC_Interpolation_Cb interpolation; // peak refinement kernel
 
 static float vx[SENSOR_N+2];
 static float vy[SENSOR_N+2];
@@ -74,6 +114,18 @@ static uint8_t vn[SENSOR_N+2];
 static uint8_t va[SENSOR_N+2];
 
 static CMC_Blob blobs[2][BLOB_MAX];
+
+_Static_assert(FRAME_BUFSIZE + BLOB_MAX*BLOB_BUFSIZE <= CHIMAERA_BUFSIZE - 2*WIZ_SEND_OFFSET,
+	"CHIMAERA_BUFSIZE too small for BLOB_MAX");
+
+enum {
+	RELATE_MATCH,
+	RELATE_OLD,
+	RELATE_NEW
+};
+
+static float relate_cost[2][BLOB_MAX+1]; // alignment cost of old and new blob lists, previous and current row
+static uint8_t relate_step[BLOB_MAX+1][BLOB_MAX+1]; // alignment step for backtracking
 static uint8_t pacemaker = 0x0b; // pacemaker rate 2^11=2048
 
 void
@@ -81,9 +133,49 @@ cmc_velocity_stiffness_update(uint8_t stiffness)
 {
 	s = 1.f / (float)stiffness;
 	sm1 = 1.f - s;
+
+	// critically damped g-h-k gains with the same memory as the IIR filter
+	float theta = sm1;
+	float theta_m1 = s;
+	g = 1.f - theta*theta*theta;
+	h = 1.5f * theta_m1*theta_m1 * (1.f + theta);
+	k = 0.5f * theta_m1*theta_m1*theta_m1;
+
 	s *= 0.5;
 }
 
+void
+cmc_prediction_update(uint8_t enabled)
+{
+	predict = enabled;
+}
+
+uint_fast8_t
+cmc_idle_level(void)
+{
+	return I ? 0 : idle_bit; // blobs present are never idle
+}
+
+// session ids of all blobs alive in the frame being processed, only valid from within engine callbacks
+uint_fast8_t
+cmc_blob_sids(int32_t *sids)
+{
+	uint_fast8_t j;
+	for(j=0; j<J; j++)
+		sids[j] = cmc_neu[j].sid;
+	return J;
+}
+
+// sensor indices of the peaks of blobs tracked in the last processed frame, in order of x
+uint_fast8_t
+cmc_blob_peaks(uint8_t *peak)
+{
+	uint_fast8_t i;
+	for(i=0; i<I; i++)
+		peak[i] = cmc_old[i].peak;
+	return I;
+}
+
 void
 cmc_init(void)
 {
@@ -104,6 +196,9 @@ cmc_init(void)
 		vn[i] = 0;
 	}
 
+	for(i=0; i<CMC_MASK_N; i++)
+		aoi_prev[i] = 0;
+
 	old = 0;
 	neu = 1;
 
@@ -116,36 +211,25 @@ cmc_init(void)
 	// update engines stack
 	cmc_engines_update();
 	cmc_velocity_stiffness_update(config.sensors.velocity_stiffness);
-}
+	cmc_prediction_update(config.sensors.prediction);
+	cmc_interpolation_update(config.sensors.interpolation_mode);
 
-#if 0
-// raw lookup
-static inline __always_inline float
-LOOKUP(float y)
-{
-	uint16_t ii = y*0x7ff;
-	return curve[ii];
-}
-#else
-// linear lookup interpolation
-static inline __always_inline float
-LOOKUP(float y)
-{
-	float f, i;
-	uint16_t ii;
-
-	y *= 0x7ff;
-	f = modff(y, &i); // fractional part
-	ii = i; // integral part
-	return curve[ii] + f*(curve[ii+1] - curve[ii]);
-}
+#if defined(BENCHMARK_INTERPOLATION) && defined(__arm__)
+	DEMCR |= 0x01000000; // TRCENA
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= 0x1; // CYCCNTENA
 #endif
+}
 
 // derive velocity and acceleration signals
 //static inline __always_inline void
 static void __CCM_TEXT__ //FIXME
 VEL_ACCEL(CMC_Blob *_old, CMC_Blob *_neu, float rate)
 {
+	if(_neu->t != _old->t) // correct frame rate by skew of acquisition times
+		rate = 1.f / (1.f/rate + _neu->t - _old->t);
+	_neu->rate = rate;
+
 	float dx = _neu->x - _old->x;
 	_neu->vx.f1 = dx * rate;
 
@@ -160,9 +244,65 @@ VEL_ACCEL(CMC_Blob *_old, CMC_Blob *_neu, float rate)
 
 	float dv =  _neu->v - _old->v;
 	_neu->m = dv * rate;
+
+	// hand over predictor state, it is updated after group scaling
+	_neu->px = _old->px;
+	_neu->py = _old->py;
 }
 
-#define VABS(A) \
+// acquisition time of a peak, weighted by the sensors contributing to it
+static inline __always_inline float
+_stamp_peak(uint_fast8_t P, const float *stamp)
+{
+	float t = 0.f;
+	float w = 0.f;
+	uint_fast8_t p;
+
+	for(p=P-1; p<=P+1; p++)
+	{
+		float y = vy[p];
+
+		if( (p < 1) || (p > SENSOR_N) || (y <= 0.f) ) // padding or below threshold
+			continue;
+
+		t += y * stamp[p-1];
+		w += y;
+	}
+
+	return w > 0.f ? t / w : stamp[P-1];
+}
+
+// reset predictor to the current measurement
+static inline __always_inline void
+_predict_reset(CMC_Pred *pred, float z)
+{
+	pred->p = z;
+	pred->v = 0.f;
+	pred->a = 0.f;
+}
+
+// g-h-k (alpha-beta-gamma) update with the current measurement
+static inline __always_inline void
+_predict_update(CMC_Pred *pred, float z, float dt, float rate)
+{
+	float p = pred->p + (pred->v + 0.5f*pred->a*dt)*dt;
+	float v = pred->v + pred->a*dt;
+	float r = z - p; // residual
+
+	pred->p = p + g*r;
+	pred->v = v + h*r*rate;
+	pred->a = pred->a + 2.f*k*r*rate*rate;
+}
+
+// extrapolate to tau seconds ahead of the current measurement
+static inline __always_inline float
+_predict_at(const CMC_Pred *pred, float tau)
+{
+	return pred->p + (pred->v + 0.5f*pred->a*tau)*tau;
+}
+
+#if defined(__arm__)
+#	define VABS(A) \
 ({ \
 	float X; \
 	asm volatile ("VABS.F32 %[res], %[val1]" \
@@ -171,17 +311,544 @@ VEL_ACCEL(CMC_Blob *_old, CMC_Blob *_neu, float rate)
 	); \
 	(float)X; \
 })
+#else // host build
+#	define VABS(A) fabsf(A)
+#endif
+
+// no interpolation
+static void __CCM_TEXT__
+_interpolation_none(uint_fast8_t P, float *x, float *y)
+{
+	float y1 = vy[P];
+
+	y1 = y1 < 0.f ? 0.f :(y1 > 1.f ? 1.f : y1);
+
+	// lookup distance
+	y1 = curve_lookup(y1);
+
+	*x = vx[P];
+	*y = y1;
+}
+
+// quadratic, aka parabolic interpolation
+static void __CCM_TEXT__
+_interpolation_quadratic(uint_fast8_t P, float *x, float *y)
+{
+	float y0 = vy[P-1];
+	float y1 = vy[P];
+	float y2 = vy[P+1];
+
+	y0 = y0 < 0.f ? 0.f :(y0 > 1.f ? 1.f : y0);
+	y1 = y1 < 0.f ? 0.f :(y1 > 1.f ? 1.f : y1);
+	y2 = y2 < 0.f ? 0.f :(y2 > 1.f ? 1.f : y2);
+
+	// lookup distance
+	y0 = curve_lookup(y0);
+	y1 = curve_lookup(y1);
+	y2 = curve_lookup(y2);
+
+	// parabolic interpolation
+	float divisor = y0 - 2.f*y1 + y2;
+	//float divisor = y0 -(y1<<1) + y2;
+
+	if(divisor == 0.f)
+	{
+		*x = vx[P];
+		*y = y1;
+	}
+	else
+	{
+		float divisor_1 = 1.f / divisor;
+		*x = vx[P] + d_2*(y0 - y2) * divisor_1; // multiplication instead of division
+		float dividend = y0*(y1 - 0.125f*y0 + 0.25f*y2) + y2*(y1 - 0.125f*y2) - y1*y1*2.f; // 7 multiplications, 5 additions/subtractions
+		*y = dividend * divisor_1; // multiplication instead of division
+	}
+}
+
+// cubic interpolation: Catmull-Rom splines
+static void __CCM_TEXT__
+_interpolation_catmull(uint_fast8_t P, float *x, float *y)
+{
+	float y0, y1, y2, y3, x1;
+
+	float tm1 = vy[P-1];
+	float thi = vy[P];
+	float tp1 = vy[P+1];
+
+	if(tm1 >= tp1)
+	{
+		x1 = vx[P-1];
+		//y0 = vy[P-2];
+		y0 = P >= 2 ? vy[P-2] : vy[P-1]; // check for underflow
+		y1 = tm1;
+		y2 = thi;
+		y3 = tp1;
+	}
+	else // tp1 > tm1
+	{
+		x1 = vx[P];
+		y0 = tm1;
+		y1 = thi;
+		y2 = tp1;
+		//y3 = vy[P+2];
+		y3 = P <= (SENSOR_N) ? vy[P+2] : vy[P+1]; // check for overflow
+	}
+
+	y0 = y0 < 0.f ? 0.f :(y0 > 1.f ? 1.f : y0);
+	y1 = y1 < 0.f ? 0.f :(y1 > 1.f ? 1.f : y1);
+	y2 = y2 < 0.f ? 0.f :(y2 > 1.f ? 1.f : y2);
+	y3 = y3 < 0.f ? 0.f :(y3 > 1.f ? 1.f : y3);
+
+	// lookup distance
+	y0 = curve_lookup(y0);
+	y1 = curve_lookup(y1);
+	y2 = curve_lookup(y2);
+	y3 = curve_lookup(y3);
+
+	// simple cubic splines
+	//float a0 = y3 - y2 - y0 + y1;
+	//float a1 = y0 - y1 - a0;
+	//float a2 = y2 - y0;
+	//float a3 = y1;
+
+	// catmull-rom splines
+	float a0 = -0.5f*y0 + 1.5f*y1 - 1.5f*y2 + 0.5f*y3;
+	float a1 = y0 - 2.5f*y1 + 2.f*y2 - 0.5f*y3;
+	float a2 = -0.5f*y0 + 0.5f*y2;
+	float a3 = y1;
+
+	float A = 3.f * a0;
+	float B = 2.f * a1;
+	float C = a2;
+
+	float mu;
+
+	if(A == 0.f)
+	{
+		mu = 0.f; // TODO what to do here? fall back to quadratic?
+	}
+	else // A != 0.f
+	{
+		if(C == 0.f)
+			mu = -B / A;
+		else
+		{
+			float A2 = 2.f*A;
+			float D = B*B - 2.f*A2*C;
+			if(D < 0.f) // bad, this'd give an imaginary solution
+				D = 0.f;
+			else
+				D = sqrtf(D);
+			mu =(-B - D) / A2;
+		}
+	}
+
+	*x = x1 + mu*d;
+	float mu2 = mu*mu;
+	*y = a0*mu2*mu + a1*mu2 + a2*mu + a3;
+}
+
+// cubic interpolation: Lagrange Poylnomial
+static void __CCM_TEXT__
+_interpolation_lagrange(uint_fast8_t P, float *x, float *y)
+{
+	float y0, y1, y2, y3, x0, x1;
+
+	x1 = vx[P];
+	y0 = vy[P-1];
+	y1 = vy[P];
+	y2 = vy[P+1];
+	//y3 = vy[P+2];
+	y3 = P <= (SENSOR_N) ? vy[P+2] : vy[P+1]; // check for overflow
+
+	y0 = y0 < 0.f ? 0.f :(y0 > 1.f ? 1.f : y0);
+	y1 = y1 < 0.f ? 0.f :(y1 > 1.f ? 1.f : y1);
+	y2 = y2 < 0.f ? 0.f :(y2 > 1.f ? 1.f : y2);
+	y3 = y3 < 0.f ? 0.f :(y3 > 1.f ? 1.f : y3);
+
+	// lookup distance
+	y0 = curve_lookup(y0);
+	y1 = curve_lookup(y1);
+	y2 = curve_lookup(y2);
+	y3 = curve_lookup(y3);
+
+	float d2 = d * d;
+	float d3 = d2 * d;
+
+	float s1 = y0 - 2.f*y1 + y2;
+	float s2 = y0 - 3.f*y1 + 3.f*y2 - y3;
+	float sq = y0*(y0 - 9.f*y1 + 6.f*y2 + y3) + y1*(21.f*y1 - 39.f*y2 + 6.f*y3) + y2*(21.f*y2 - 9.f*y3) + y3*y3;
+
+	if(sq < 0.f) // bad, this'd give an imaginary solution
+		sq = 0.f;
+
+	if(s2 == 0)
+		x0 = x1; //FIXME what to do here?
+	else
+		x0 =(3.f*d*s1 + 3.f*x1*s2 + sqrtf(3.f)*d*sqrtf(
+			y0*(y0 - 9.f*y1 + 6.f*y2 + y3) + y1*(21.f*y1 - 39.f*y2 + 6.f*y3) + y2*(21.f*y2 - 9.f*y3) + y3*y3
+		)) /(3.f*s2);
+
+	float X1 = x0 - x1;
+	float X2 = X1 * X1;
+	float X3 = X2 * X1;
+
+	*x = x0;
+	*y = -(-6.f*d3*y1 + d2*X1*(2.f*y0 + 3.f*y1 - 6.f*y2 + y3) - 3.f*d*X2*s1 + X3*s2) /(6.f*d3);
+}
+
+static void __CCM_TEXT__
+_interpolation_invalid(uint_fast8_t P, float *x, float *y)
+{
+	(void)P;
+	*x = 0.f;
+	*y = 0.f;
+}
+
+static const CMC_Interpolation_Cb interpolations [] = {
+	[INTERPOLATION_NONE]			= _interpolation_none,
+	[INTERPOLATION_QUADRATIC]	= _interpolation_quadratic,
+	[INTERPOLATION_CATMULL]		= _interpolation_catmull,
+	[INTERPOLATION_LAGRANGE]	= _interpolation_lagrange
+};
+
+void
+cmc_interpolation_update(uint8_t mode)
+{
+	if(mode < sizeof(interpolations)/sizeof(CMC_Interpolation_Cb))
+		interpolation = interpolations[mode];
+	else
+		interpolation = _interpolation_invalid;
+}
+
+// check whether the 1:1 relation of equally long lists stays within the gate
+static inline __always_inline uint_fast8_t
+_relate_gated(void)
+{
+	uint_fast8_t j;
+	for(j=0; j<J; j++)
+		if(VABS(cmc_neu[j].x - cmc_old[j].x) > CMC_GATE)
+			return 0;
+
+	return 1;
+}
+
+static void __CCM_TEXT__
+_relate_new(CMC_Blob *_neu)
+{
+	if(_neu->above_thresh) // check whether it is above threshold for a new blob
+	{
+		_neu->sid = ++(sid); // this is a new blob
+		_neu->group = NULL;
+		_neu->state = CMC_BLOB_APPEARED;
+	}
+	else
+		_neu->state = CMC_BLOB_IGNORED;
+}
+
+/*
+ * both lists are ordered according to x, so the assignment with minimal total
+ * displacement does not cross and can be found by aligning the lists:
+ * matching costs the displacement (only allowed within the gate), leaving an
+ * old or new blob unmatched costs the gate distance.
+ */
+static uint_fast8_t __CCM_TEXT__
+_relate_optimal(float rate)
+{
+	uint_fast8_t changed = 0;
+	uint_fast8_t i, j;
+
+	for(i=0; i<=I; i++)
+		relate_step[i][0] = RELATE_OLD;
+	for(j=0; j<=J; j++)
+	{
+		relate_cost[0][j] = j * CMC_GATE;
+		relate_step[0][j] = RELATE_NEW;
+	}
+
+	for(i=1; i<=I; i++)
+	{
+		const float *prev = relate_cost[(i-1) & 1];
+		float *cur = relate_cost[i & 1];
+
+		cur[0] = i * CMC_GATE;
+
+		for(j=1; j<=J; j++)
+		{
+			float best = prev[j] + CMC_GATE; // old blob has disappeared
+			uint8_t step = RELATE_OLD;
+
+			float cost = cur[j-1] + CMC_GATE; // new blob has appeared
+			if(cost < best)
+			{
+				best = cost;
+				step = RELATE_NEW;
+			}
+
+			float diff = VABS(cmc_neu[j-1].x - cmc_old[i-1].x);
+			if(diff <= CMC_GATE)
+			{
+				cost = prev[j-1] + diff; // 1:1 relation
+				if(cost <= best)
+				{
+					best = cost;
+					step = RELATE_MATCH;
+				}
+			}
+
+			cur[j] = best;
+			relate_step[i][j] = step;
+		}
+	}
+
+	// backtrack
+	i = I;
+	j = J;
+	while(i || j)
+	{
+		switch(relate_step[i][j])
+		{
+			case RELATE_MATCH:
+			{
+				i--;
+				j--;
+				cmc_neu[j].sid = cmc_old[i].sid;
+				cmc_neu[j].group = cmc_old[i].group;
+				cmc_neu[j].state = (cmc_old[i].x == cmc_neu[j].x) && (cmc_old[i].y == cmc_neu[j].y) ? CMC_BLOB_EXISTED_STILL : CMC_BLOB_EXISTED_DIRTY;
+				memcpy(cmc_neu[j].sent, cmc_old[i].sent, sizeof(cmc_neu[j].sent));
+				VEL_ACCEL(&cmc_old[i], &cmc_neu[j], rate);
+
+				changed = changed || (cmc_neu[j].state == CMC_BLOB_EXISTED_DIRTY);
+				break;
+			}
+			case RELATE_OLD:
+			{
+				i--;
+				cmc_old[i].state = CMC_BLOB_DISAPPEARED;
+
+				changed = 1;
+				break;
+			}
+			case RELATE_NEW:
+			{
+				j--;
+				cmc_neu[j].state = CMC_BLOB_INVALID; // mark as unrelated
+				break;
+			}
+		}
+	}
+
+	// hand out new ids in order of x
+	for(j=0; j<J; j++)
+		if(cmc_neu[j].state == CMC_BLOB_INVALID)
+		{
+			_relate_new(&cmc_neu[j]);
+
+			changed = changed || (cmc_neu[j].state == CMC_BLOB_APPEARED);
+		}
+
+	return changed;
+}
+
+static inline void
+_mark_update(uint16_t *mark, osc_data_t *from, osc_data_t *to, osc_data_t *end)
+{
+	if(!from)
+		return;
+
+	uint16_t size = to ? to - from : end - from + 1; // lower bound when overflown
+	if(size > *mark)
+		*mark = size;
+}
+
+typedef struct _Split Split;
+
+struct _Split {
+	CMC_Engine *engine;
+	CMC_Frame_Event *fev;
+	uint_fast8_t e;
+	uint_fast8_t part; // blobs in this part of the engine bundle
+	uint_fast8_t first; // index of the first blob in this part
+	uint_fast8_t n; // index of the blob being serialized
+	uint_fast8_t cont; // whether this part continues the engine bundle of a previous packet
+	uint_fast8_t fresh; // whether this part starts a packet
+	uint_fast8_t rewind; // this part has been dropped, serialize again from its first blob
+	osc_data_t *base; // start of engine bundle in current packet
+	osc_data_t *end;
+};
+
+// whether dropping the current part gains space, it does unless a lone blob already started a packet
+static inline uint_fast8_t
+_rewindable(Split *split)
+{
+	return (split->part > 1) || !split->fresh;
+}
+
+// hand over the packet without the current part and reopen it in a fresh one to serialize its blobs again
+static osc_data_t *
+_rewind(Split *split)
+{
+	CMC_Engine *engine = split->engine;
+	CMC_Frame_Event *fev = split->fev;
+	osc_data_t *buf;
+
+	buf = cmc_flush_cb(split->base, &split->end);
+	split->base = buf;
+	split->fresh = 1;
+	fev->split = split->cont;
+	if(engine->frame_cb)
+		buf = engine->frame_cb(buf, split->end, fev);
+	fev->split = 0;
+	split->part = 0;
+	split->rewind = 1;
+
+	return buf;
+}
+
+// close the engine bundle, hand the packet to the caller and reopen the bundle in a fresh one
+static osc_data_t *
+_split(Split *split, osc_data_t *buf)
+{
+	CMC_Engine *engine = split->engine;
+	CMC_Frame_Event *fev = split->fev;
+	osc_data_t *mark = buf;
+
+	fev->split = 1;
+	if(engine->end_cb)
+		buf = engine->end_cb(buf, split->end, fev);
+	_mark_update(&engines_tail[split->e], mark, buf, split->end);
+	if(!buf) // closing messages outgrew their budget
+	{
+		if(_rewindable(split))
+			return _rewind(split);
+		buf = split->base; // not even a lone blob fits, drop this part of the engine bundle
+	}
+	buf = cmc_flush_cb(buf, &split->end);
+	split->base = buf;
+	split->fresh = 1;
+	split->cont = 1;
+	if(engine->frame_cb)
+		buf = engine->frame_cb(buf, split->end, fev);
+	fev->split = 0;
+	split->part = 0;
+	split->first = split->n; // the part goes on with the blob at hand
+
+	return buf;
+}
+
+static osc_data_t *
+_blob_serialize(CMC_Engine *engine, const CMC_Blob *tar, CMC_Blob_Event *bev, osc_data_t *buf, osc_data_t *end)
+{
+	switch(tar->state)
+	{
+		case CMC_BLOB_APPEARED:
+			if(engine->on_cb)
+				buf = engine->on_cb(buf, end, bev);
+			break;
+		case CMC_BLOB_DISAPPEARED:
+			if(tar->y != bev->y)
+				buf = engine->set_cb(buf, end, bev);
+			buf = engine->off_cb(buf, end, bev);
+			break;
+		default: // (tar->state == CMC_BLOB_EXISTED_DIRTY) || (tar->state == CMC_BLOB_EXISTED_STILL)
+			if(engine->set_cb)
+				buf = engine->set_cb(buf, end, bev);
+			break;
+	}
+
+	return buf;
+}
+
+// fill in the event of a new blob, extrapolated to the output offset tau when predicting
+static void
+_blob_event(const CMC_Blob *tar, float tau, CMC_Blob_Event *bev)
+{
+	*bev = (CMC_Blob_Event){
+		.sid = tar->sid,
+		.gid = tar->group->gid,
+		.pid = tar->pid,
+		.x = tar->x,
+		.y = tar->y,
+		.vx = tar->vx.f11,
+		.vy = tar->vy.f11,
+		.m = tar->m
+	};
+
+	if(predict)
+	{
+		float dt = tau - tar->t; // time from acquisition to scheduled output
+		float y = _predict_at(&tar->py, dt);
+		float ax = tar->px.a;
+		float ay = tar->py.a;
+		float v;
+
+		bev->x = _predict_at(&tar->px, dt);
+		bev->y = y < 0.f ? 0.f :(y > 1.f ? 1.f : y); // 0 <= y <= 1
+		bev->vx = tar->px.v + ax*dt;
+		bev->vy = tar->py.v + ay*dt;
+
+		// acceleration along the direction of motion
+		v = sqrtf(bev->vx*bev->vx + bev->vy*bev->vy);
+		bev->m = v > 0.f ? (bev->vx*ax + bev->vy*ay) / v : 0.f;
+	}
+}
+
+// serialize a blob, splitting the packet ahead of an overflow, or after one when the blob outgrew its budget
+static osc_data_t *
+_blob(Split *split, const CMC_Blob *tar, CMC_Blob_Event *bev, osc_data_t *buf)
+{
+	uint_fast8_t e = split->e;
+	osc_data_t *mark;
+
+	if(split->part && (!buf || (split->end - buf < engines_blob[e] + engines_tail[e]) ) )
+	{
+		buf = _split(split, buf);
+		if(split->rewind)
+			return buf;
+	}
+
+	mark = buf;
+	buf = _blob_serialize(split->engine, tar, bev, buf, split->end);
+	_mark_update(&engines_blob[e], mark, buf, split->end);
+	if(mark && !buf)
+	{
+		buf = _split(split, mark);
+		if(split->rewind)
+			return buf;
+		buf = _blob_serialize(split->engine, tar, bev, buf, split->end);
+	}
+	split->part++;
+
+	return buf;
+}
+
+static inline int32_t
+_q15(float f)
+{
+	return f * 0x7fff + 0.5f;
+}
+
+// whether a blob stayed within tolerance (Q15) of the position last sent to the engine in slot e
+static inline uint_fast8_t
+_quiet(const CMC_Blob *tar, uint_fast8_t e, int32_t tolerance)
+{
+	if( (tar->state != CMC_BLOB_EXISTED_STILL) && (tar->state != CMC_BLOB_EXISTED_DIRTY) )
+		return 0;
+
+	return (abs(_q15(tar->x) - tar->sent[e][0]) <= tolerance)
+		&& (abs(_q15(tar->y) - tar->sent[e][1]) <= tolerance);
+}
 
 static OSC_Timetag last; // timestamp of last loop
 
 osc_data_t *__CCM_TEXT__
-cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf, osc_data_t *end)
+cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, const CMC_Mask *mask, const float *stamp, osc_data_t *buf, osc_data_t *end)
 {
 	/*
 	 * derive REAL update rate for velocity and acceleration calculations
 	 */
 	float rate;
-	if(last > 0ULLK)
+	if(last > 0)
 		rate = 1.f / (now - last);
 	else
 		rate = config.sensors.rate;
@@ -191,25 +858,55 @@ cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf,
 	/*
 	 * find areas of interest
 	 */
-	n_aoi = 0;
+	uint_fast8_t w;
 	uint_fast8_t pos;
-	for(pos=0; pos<SENSOR_N; pos++)
+
+	if(!mask) // no fused mask from adc_fill, do the packed scan here
 	{
-		uint_fast8_t newpos = pos+1;
-		int16_t val = rela[pos];
-		uint16_t aval = abs(val);
-		if( (aval << 1) > range.thresh[pos] ) // aval > thresh / 2?
+		uint32_t *rela_vec32 =(uint32_t *)rela;
+		uint32_t *thresh_vec32 =(uint32_t *)range.thresh;
+
+		cmc_mask_clear(&aoi_mask);
+		for(pos=0; pos<SENSOR_N/2; pos++)
+			cmc_mask_pair(&aoi_mask, pos, rela_vec32[pos], thresh_vec32[pos]);
+
+		mask = &aoi_mask;
+	}
+
+	// per-sensor work only for set bits, found via CLZ in ascending order
+	n_aoi = 0;
+	for(w=0; w<CMC_MASK_N; w++)
+	{
+		uint32_t m = mask->aoi[w];
+		uint32_t clear = aoi_prev[w] & ~m; // candidates of previous cycle which went idle
+		aoi_prev[w] = m;
+
+		while(clear)
 		{
-			aoi[n_aoi++] = newpos;
+			uint_fast8_t idx = __builtin_clz(clear);
+			clear &= ~(0x80000000UL >> idx);
+			vy[(w << 5) + idx + 1] = 0.0;
+		}
 
-			vn[newpos] = val < 0 ? POLE_NORTH : POLE_SOUTH;
+		while(m)
+		{
+			uint_fast8_t idx = __builtin_clz(m);
+			uint32_t bit = 0x80000000UL >> idx;
+			m &= ~bit;
+
+			pos =(w << 5) + idx;
+			uint_fast8_t newpos = pos+1;
+			uint16_t aval = abs(rela[pos]);
+
+			if(n_aoi < sizeof(aoi))
+				aoi[n_aoi++] = newpos;
+
+			vn[newpos] = mask->north[w] & bit ? POLE_NORTH : POLE_SOUTH;
 			va[newpos] = aval > range.thresh[pos];
 
 			float y =((float)aval * range.U[pos]) - range.W;
 			vy[newpos] = y;
 		}
-		else
-			vy[newpos] = 0.0;
 	}
 
 	/*
@@ -228,7 +925,8 @@ cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf,
 		{
 			if(vy[p1] < vy[p0])
 			{
-				peaks[n_peaks++] = p0;
+				if(n_peaks < BLOB_MAX) // further peaks are dropped
+					peaks[n_peaks++] = p0;
 				up = 0;
 			}
 			// else up := 1
@@ -251,189 +949,14 @@ cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf,
 		float x, y;
 		uint_fast8_t P = peaks[p];
 
-		switch(config.sensors.interpolation_mode)
-		{
-			case INTERPOLATION_NONE: // no interpolation
-			{
-        float y1 = vy[P];
-
-				y1 = y1 < 0.f ? 0.f :(y1 > 1.f ? 1.f : y1);
-
-				// lookup distance
-				y1 = LOOKUP(y1);
-
-        x = vx[P]; 
-        y = y1;
-
-				break;
-			}
-			case INTERPOLATION_QUADRATIC: // quadratic, aka parabolic interpolation
-			{
-				float y0 = vy[P-1];
-				float y1 = vy[P];
-				float y2 = vy[P+1];
-
-				y0 = y0 < 0.f ? 0.f :(y0 > 1.f ? 1.f : y0);
-				y1 = y1 < 0.f ? 0.f :(y1 > 1.f ? 1.f : y1);
-				y2 = y2 < 0.f ? 0.f :(y2 > 1.f ? 1.f : y2);
-
-				// lookup distance
-				y0 = LOOKUP(y0);
-				y1 = LOOKUP(y1);
-				y2 = LOOKUP(y2);
-
-				// parabolic interpolation
-				float divisor = y0 - 2.f*y1 + y2;
-				//float divisor = y0 -(y1<<1) + y2;
-
-				if(divisor == 0.f)
-				{
-					x = vx[P];
-					y = y1;
-				}
-				else
-				{
-					float divisor_1 = 1.f / divisor;
-					x = vx[P] + d_2*(y0 - y2) * divisor_1; // multiplication instead of division
-					float dividend = y0*(y1 - 0.125f*y0 + 0.25f*y2) + y2*(y1 - 0.125f*y2) - y1*y1*2.f; // 7 multiplications, 5 additions/subtractions
-					y = dividend * divisor_1; // multiplication instead of division
-				}
-				break;
-			}
-			case INTERPOLATION_CATMULL: // cubic interpolation: Catmull-Rom splines
-			{
-				float y0, y1, y2, y3, x1;
-
-				float tm1 = vy[P-1];
-				float thi = vy[P];
-				float tp1 = vy[P+1];
-
-				if(tm1 >= tp1)
-				{
-					x1 = vx[P-1];
-					//y0 = vy[P-2];
-					y0 = P >= 2 ? vy[P-2] : vy[P-1]; // check for underflow
-					y1 = tm1;
-					y2 = thi;
-					y3 = tp1;
-				}
-				else // tp1 > tm1
-				{
-					x1 = vx[P];
-					y0 = tm1;
-					y1 = thi;
-					y2 = tp1;
-					//y3 = vy[P+2];
-					y3 = P <= (SENSOR_N) ? vy[P+2] : vy[P+1]; // check for overflow
-				}
-
-				y0 = y0 < 0.f ? 0.f :(y0 > 1.f ? 1.f : y0);
-				y1 = y1 < 0.f ? 0.f :(y1 > 1.f ? 1.f : y1);
-				y2 = y2 < 0.f ? 0.f :(y2 > 1.f ? 1.f : y2);
-				y3 = y3 < 0.f ? 0.f :(y3 > 1.f ? 1.f : y3);
-
-				// lookup distance
-				y0 = LOOKUP(y0);
-				y1 = LOOKUP(y1);
-				y2 = LOOKUP(y2);
-				y3 = LOOKUP(y3);
-
-				// simple cubic splines
-				//float a0 = y3 - y2 - y0 + y1;
-				//float a1 = y0 - y1 - a0;
-				//float a2 = y2 - y0;
-				//float a3 = y1;
-			
-				// catmull-rom splines
-				float a0 = -0.5f*y0 + 1.5f*y1 - 1.5f*y2 + 0.5f*y3;
-				float a1 = y0 - 2.5f*y1 + 2.f*y2 - 0.5f*y3;
-				float a2 = -0.5f*y0 + 0.5f*y2;
-				float a3 = y1;
-
-        float A = 3.f * a0;
-        float B = 2.f * a1;
-        float C = a2;
-
-				float mu;
-
-        if(A == 0.f)
-        {
-          mu = 0.f; // TODO what to do here? fall back to quadratic?
-        }
-        else // A != 0.f
-        {
-          if(C == 0.f)
-            mu = -B / A;
-          else
-          {
-            float A2 = 2.f*A;
-            float D = B*B - 2.f*A2*C;
-            if(D < 0.f) // bad, this'd give an imaginary solution
-              D = 0.f;
-            else
-              D = sqrtf(D);
-            mu =(-B - D) / A2;
-          }
-        }
-
-				x = x1 + mu*d;
-				float mu2 = mu*mu;
-				y = a0*mu2*mu + a1*mu2 + a2*mu + a3;
-
-				break;
-			}
-			case INTERPOLATION_LAGRANGE: // cubic interpolation: Lagrange Poylnomial
-			{
-				float y0, y1, y2, y3, x1;
-
-				x1 = vx[P];
-				y0 = vy[P-1];
-				y1 = vy[P];
-				y2 = vy[P+1];
-				//y3 = vy[P+2];
-				y3 = P <= (SENSOR_N) ? vy[P+2] : vy[P+1]; // check for overflow
-
-				y0 = y0 < 0.f ? 0.f :(y0 > 1.f ? 1.f : y0);
-				y1 = y1 < 0.f ? 0.f :(y1 > 1.f ? 1.f : y1);
-				y2 = y2 < 0.f ? 0.f :(y2 > 1.f ? 1.f : y2);
-				y3 = y3 < 0.f ? 0.f :(y3 > 1.f ? 1.f : y3);
-
-				// lookup distance
-				y0 = LOOKUP(y0);
-				y1 = LOOKUP(y1);
-				y2 = LOOKUP(y2);
-				y3 = LOOKUP(y3);
-
-				float d2 = d * d;
-				float d3 = d2 * d;
-
-				float s1 = y0 - 2.f*y1 + y2;
-				float s2 = y0 - 3.f*y1 + 3.f*y2 - y3;
-				float sq = y0*(y0 - 9.f*y1 + 6.f*y2 + y3) + y1*(21.f*y1 - 39.f*y2 + 6.f*y3) + y2*(21.f*y2 - 9.f*y3) + y3*y3;
-
-				if(sq < 0.f) // bad, this'd give an imaginary solution
-					sq = 0.f;
-
-				if(s2 == 0)
-					x = x1; //FIXME what to do here?
-				else
-					x =(3.f*d*s1 + 3.f*x1*s2 + sqrtf(3.f)*d*sqrtf(
-						y0*(y0 - 9.f*y1 + 6.f*y2 + y3) + y1*(21.f*y1 - 39.f*y2 + 6.f*y3) + y2*(21.f*y2 - 9.f*y3) + y3*y3
-					)) /(3.f*s2);
-
-				float X1 = x - x1;
-				float X2 = X1 * X1;
-				float X3 = X2 * X1;
-
-				y = -(-6.f*d3*y1 + d2*X1*(2.f*y0 + 3.f*y1 - 6.f*y2 + y3) - 3.f*d*X2*s1 + X3*s2) /(6.f*d3);
-
-				break;
-			}
-			default:
-				x = 0.f;
-				y = 0.f;
-				break;
-		}
+#ifdef BENCHMARK_INTERPOLATION
+		uint32_t c0 = CYCLES();
+		interpolation(P, &x, &y);
+		cmc_interpolation_cycles += (uint32_t)(CYCLES() - c0);
+		cmc_interpolation_peaks++;
+#else
+		interpolation(P, &x, &y); // peak refinement, selected by cmc_interpolation_update
+#endif
 
 		//TODO check for NaN
 		x = x < 0.f ? 0.f :(x > 1.f ? 1.f : x); // 0 <= x <= 1
@@ -454,6 +977,9 @@ cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf,
 		memset(&blob->vy, 0, sizeof(CMC_Filt));
 		blob->v = 0.f;
 		blob->m = 0.f;
+		blob->t = stamp ? _stamp_peak(P, stamp) : 0.f;
+		blob->rate = rate;
+		blob->peak = P - 1;
 		blob->above_thresh = va[P];
 		blob->state = CMC_BLOB_INVALID;
 
@@ -468,128 +994,21 @@ cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf,
 	uint_fast8_t i, j;
 	if(I || J)
 	{
-		switch((J > I) - (J < I) ) // == signum(J-I)
+		if( (I == J) && _relate_gated() ) // there has been no change in blob number, so we can relate the old and new lists 1:1 as they are both ordered according to x
 		{
-			case -1: // old blobs have disappeared
-			{
-				uint_fast8_t n_less = I - J; // how many blobs have disappeared
-				i = 0;
-				for(j=0; j<J; )
-				{
-					float diff0, diff1;
-
-					if(n_less)
-					{
-						diff0 = VABS(cmc_neu[j].x - cmc_old[i].x);
-						diff1 = VABS(cmc_neu[j].x - cmc_old[i+1].x);
-					}
-
-					if( n_less && (diff1 < diff0) )
-					{
-						cmc_old[i].state = CMC_BLOB_DISAPPEARED;
-
-						n_less--;
-						i++;
-						// do not increase j
-					}
-					else
-					{
-						cmc_neu[j].sid = cmc_old[i].sid;
-						cmc_neu[j].group = cmc_old[i].group;
-						cmc_neu[j].state = (cmc_old[i].x == cmc_neu[j].x) && (cmc_old[i].y == cmc_neu[j].y) ? CMC_BLOB_EXISTED_STILL : CMC_BLOB_EXISTED_DIRTY;
-						VEL_ACCEL(&cmc_old[i], &cmc_neu[j], rate);
-
-						i++;
-						j++;
-					}
-				}
-
-				// if(n_less)
-				for(i=I - n_less; i<I; i++)
-					cmc_old[i].state = CMC_BLOB_DISAPPEARED;
-						
-				changed = changed || 1;
-
-				break;
-			}
-
-			case 0: // there has been no change in blob number, so we can relate the old and new lists 1:1 as they are both ordered according to x
-			{
-				for(j=0; j<J; j++)
-				{
-					cmc_neu[j].sid = cmc_old[j].sid;
-					cmc_neu[j].group = cmc_old[j].group;
-					cmc_neu[j].state = (cmc_old[j].x == cmc_neu[j].x) && (cmc_old[j].y == cmc_neu[j].y) ? CMC_BLOB_EXISTED_STILL : CMC_BLOB_EXISTED_DIRTY;
-					VEL_ACCEL(&cmc_old[j], &cmc_neu[j], rate);
-
-					changed = changed || (cmc_neu[j].state == CMC_BLOB_EXISTED_DIRTY);
-				}
-
-				break;
-			}
-
-			case 1: // new blobs have appeared
+			for(j=0; j<J; j++)
 			{
-				uint_fast8_t n_more = J - I; // how many blobs have appeared
-				j = 0;
-				for(i=0; i<I; )
-				{
-					float diff0, diff1;
-					
-					if(n_more) // only calculate differences when there are still new blobs to be found
-					{
-						diff0 = VABS(cmc_neu[j].x - cmc_old[i].x);
-						diff1 = VABS(cmc_neu[j+1].x - cmc_old[i].x);
-					}
-
-					if( n_more && (diff1 < diff0) ) // cmc_neu[j] is the new blob
-					{
-						if(cmc_neu[j].above_thresh) // check whether it is above threshold for a new blob
-						{
-							cmc_neu[j].sid = ++(sid); // this is a new blob
-							cmc_neu[j].group = NULL;
-							cmc_neu[j].state = CMC_BLOB_APPEARED;
-
-							changed = changed || 1;
-						}
-						else
-							cmc_neu[j].state = CMC_BLOB_IGNORED;
-
-						n_more--;
-						j++;
-						// do not increase i
-					}
-					else // 1:1 relation
-					{
-						cmc_neu[j].sid = cmc_old[i].sid;
-						cmc_neu[j].group = cmc_old[i].group;
-						cmc_neu[j].state = (cmc_old[i].x == cmc_neu[j].x) && (cmc_old[i].y == cmc_neu[j].y) ? CMC_BLOB_EXISTED_STILL : CMC_BLOB_EXISTED_DIRTY;
-						VEL_ACCEL(&cmc_old[i], &cmc_neu[j], rate);
-
-						changed = changed || (cmc_neu[j].state == CMC_BLOB_EXISTED_DIRTY);
-						j++;
-						i++;
-					}
-				}
-
-				//if(n_more)
-				for(j=J - n_more; j<J; j++)
-				{
-					if(cmc_neu[j].above_thresh) // check whether it is above threshold for a new blob
-					{
-						cmc_neu[j].sid = ++(sid); // this is a new blob
-						cmc_neu[j].group = NULL;
-						cmc_neu[j].state = CMC_BLOB_APPEARED;
-
-						changed = changed || 1;
-					}
-					else
-						cmc_neu[j].state = CMC_BLOB_IGNORED;
-				}
+				cmc_neu[j].sid = cmc_old[j].sid;
+				cmc_neu[j].group = cmc_old[j].group;
+				cmc_neu[j].state = (cmc_old[j].x == cmc_neu[j].x) && (cmc_old[j].y == cmc_neu[j].y) ? CMC_BLOB_EXISTED_STILL : CMC_BLOB_EXISTED_DIRTY;
+				memcpy(cmc_neu[j].sent, cmc_old[j].sent, sizeof(cmc_neu[j].sent));
+				VEL_ACCEL(&cmc_old[j], &cmc_neu[j], rate);
 
-				break;
+				changed = changed || (cmc_neu[j].state == CMC_BLOB_EXISTED_DIRTY);
 			}
 		}
+		else // blobs have appeared and/or disappeared
+			changed = _relate_optimal(rate);
 
 		/*
 		 * overwrite blobs that are to be ignored
@@ -646,6 +1065,21 @@ cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf,
 					break; // match found, do not search further
 				}
 			}
+
+			if(predict)
+			{
+				if(tar->state == CMC_BLOB_APPEARED)
+				{
+					_predict_reset(&tar->px, tar->x);
+					_predict_reset(&tar->py, tar->y);
+				}
+				else // EXISTED_STILL, EXISTED_DIRTY
+				{
+					float dt = 1.f / tar->rate;
+					_predict_update(&tar->px, tar->x, dt, tar->rate);
+					_predict_update(&tar->py, tar->y, dt, tar->rate);
+				}
+			}
 		}
 
 		if(changed)
@@ -688,6 +1122,33 @@ cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf,
 #endif
 
 		float zero = config.output.invert.z ? 1.f : 0.f;
+		float tau = offset > now ? offset - now : 0.f; // time from frame timestamp to scheduled output, zero for immediate bundles
+
+		OSC_Timetag acquired = now; // mean acquisition time of frame
+		if(stamp)
+		{
+			float t = 0.f;
+			for(pos=0; pos<SENSOR_N; pos++)
+				t += stamp[pos];
+			t *= 1.f / SENSOR_N;
+
+			if(t < 0.f)
+				acquired = now - (OSC_Timetag)(-t);
+		}
+
+		// idle frames and every keepalive'th frame refresh all blobs of delta engines
+		uint_fast8_t refresh = !changed
+			|| (config.output.keepalive && !(fid % config.output.keepalive));
+
+		int32_t tolerance = _q15(config.output.tolerance);
+
+		// on/off events reach decimated engines on every frame
+		uint_fast8_t events = 0;
+		for(j=0; j<J; j++)
+			events |= cmc_neu[j].state == CMC_BLOB_APPEARED;
+		for(i=0; i<I; i++)
+			events |= cmc_old[i].state == CMC_BLOB_DISAPPEARED;
+
 		uint_fast8_t e;
 		for(e=0; e<ENGINE_MAX; e++)
 		{
@@ -696,69 +1157,153 @@ cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf,
 			if( !(engine = engines[e]) ) // terminator reached
 				break;
 
+			uint_fast8_t decimation = *engines_decimation[e];
+			uint_fast8_t due = !changed || (decimation <= 1) || !(fid % decimation); // send set events?
+			if(!due && !events)
+				continue; // nothing to deliver to this engine
+
+			uint_fast8_t dest = OUTPUT_FANOUT_MAX ? engines_dest[e] : 0; // lets the fan-out paths fold away without destinations
+			osc_data_t *out = dest ? cmc_fanout[dest-1].ptr : buf_ptr;
+
 			CMC_Frame_Event fev = {
 				.fid = fid,
-				.now = now,
+				.now = acquired,
 				.offset = offset,
 				.nblob_old = I,
-				.nblob_new = J
+				.nblob_new = J,
+				.nested = cmc_dest_engines[dest] + (dest ? 0 : config.dump.enabled) > 1,
+				.split = 0
 			};
 
+			// split packets of the output socket at engine and blob boundaries instead of overflowing
+			uint_fast8_t splittable = !dest && cmc_flush_cb;
+			Split split = {
+				.engine = engine,
+				.fev = &fev,
+				.e = e,
+				.part = 0,
+				.end = dest ? cmc_fanout[dest-1].end : end
+			};
+			osc_data_t *mark;
+
+			if(splittable && (!out || (split.end - out < engines_head[e] + engines_blob[e] + engines_tail[e]) ) )
+			{
+				out = cmc_flush_cb(out, &split.end);
+				split.fresh = 1;
+			}
+
+			split.base = out;
 			if(engine->frame_cb)
-				buf_ptr = engine->frame_cb(buf_ptr, end, &fev);
+				out = engine->frame_cb(out, split.end, &fev);
+			_mark_update(&engines_head[e], split.base, out, split.end);
+			if(splittable && split.base && !out) // header outgrew its budget, start over in a fresh packet
+			{
+				split.base = out = cmc_flush_cb(split.base, &split.end);
+				split.fresh = 1;
+				if(engine->frame_cb)
+					out = engine->frame_cb(out, split.end, &fev);
+			}
+
+			uint_fast8_t still = due && (refresh || !*engines_deltas[e]); // send still blobs?
+			uint32_t delivered = 0; // new blobs serialized for this engine
 
-			if(engine->on_cb || engine->set_cb)
-				for(j=0; j<J; j++)
+			// new blobs first, then disappeared ones, rewound to the first blob of a part whose closing messages did not fit
+			uint_fast8_t n = 0;
+			while(1)
+			{
+				for( ; n<J+I; n++)
 				{
-					CMC_Blob *tar = &cmc_neu[j];
-					CMC_Blob_Event bev = {
-						.sid = tar->sid,
-						.gid = tar->group->gid,
-						.pid = tar->pid,
-						.x = tar->x,
-						.y = tar->y,
-						.vx = tar->vx.f11,
-						.vy = tar->vy.f11,
-						.m = tar->m
-					};
-
-					if(tar->state == CMC_BLOB_APPEARED)
+					CMC_Blob *tar;
+					CMC_Blob_Event bev;
+
+					if(n < J)
 					{
-						if(engine->on_cb)
-							buf_ptr = engine->on_cb(buf_ptr, end, &bev);
+						tar = &cmc_neu[n];
+
+						if(!engine->on_cb && !engine->set_cb)
+							continue;
+						if(!due && (tar->state == CMC_BLOB_EXISTED_DIRTY) )
+							continue;
+						if(!still && !refresh && _quiet(tar, e, tolerance))
+							continue;
+
+						_blob_event(tar, tau, &bev);
 					}
-					else // (tar->state == CMC_BLOB_EXISTED_DIRTY) || (tar->state == CMC_BLOB_EXISTED_STILLA)
+					else
 					{
-						if(engine->set_cb)
-							buf_ptr = engine->set_cb(buf_ptr, end, &bev);
+						tar = &cmc_old[n - J];
+
+						if(!engine->off_cb || (tar->state != CMC_BLOB_DISAPPEARED) )
+							continue;
+
+						bev = (CMC_Blob_Event){
+							.sid = tar->sid,
+							.gid = tar->group->gid,
+							.pid = tar->pid,
+							.x = tar->x,
+							.y = zero,
+							.vx = 0.f, //FIXME
+							.vy = 0.f, //FIXME
+							.m = 0.f //FIXME
+						};
 					}
+
+					split.n = n;
+					if(splittable)
+						out = _blob(&split, tar, &bev, out);
+					else
+						out = _blob_serialize(engine, tar, &bev, out, split.end);
+
+					if(split.rewind)
+						break;
+					if(out && (n < J) ) // this engine has got the position
+						delivered |= 1UL << n;
 				}
 
-			if(engine->off_cb)
-				for(i=0; i<I; i++)
+				if(!split.rewind)
 				{
-					CMC_Blob *tar = &cmc_old[i];
-					CMC_Blob_Event bev = {
-						.sid = tar->sid,
-						.gid = tar->group->gid,
-						.pid = tar->pid,
-						.x = tar->x,
-						.y = zero,
-						.vx = 0.f, //FIXME
-						.vy = 0.f, //FIXME
-						.m = 0.f //FIXME
-					};
-
-					if(tar->state == CMC_BLOB_DISAPPEARED)
+					mark = out;
+					if(engine->end_cb)
+						out = engine->end_cb(out, split.end, &fev);
+					_mark_update(&engines_tail[e], mark, out, split.end);
+					if(splittable && mark && !out) // closing messages outgrew their budget
 					{
-						if(tar->y != zero)
-							buf_ptr = engine->set_cb(buf_ptr, end, &bev);
-						buf_ptr = engine->off_cb(buf_ptr, end, &bev);
+						if(!_rewindable(&split)) // not even a lone blob fits, drop this part of the engine bundle
+						{
+							out = cmc_flush_cb(split.base, &split.end);
+							fev.split = 1;
+							if(engine->frame_cb)
+								out = engine->frame_cb(out, split.end, &fev);
+							fev.split = 0;
+							out = engine->end_cb(out, split.end, &fev);
+							break;
+						}
+
+						out = _rewind(&split);
 					}
 				}
 
-			if(engine->end_cb)
-				buf_ptr = engine->end_cb(buf_ptr, end, &fev);
+				if(!split.rewind)
+					break;
+
+				split.rewind = 0;
+				n = split.first;
+			}
+
+			for(j=0; j<J; j++)
+				if(delivered & (1UL << j))
+				{
+					cmc_neu[j].sent[e][0] = _q15(cmc_neu[j].x);
+					cmc_neu[j].sent[e][1] = _q15(cmc_neu[j].y);
+				}
+
+			if(dest)
+				cmc_fanout[dest-1].ptr = out;
+			else
+			{
+				buf_ptr = out;
+				end = split.end; // may have moved on to a fresh packet
+			}
 		}
 	}
 
@@ -835,28 +1380,100 @@ cmc_group_update(void)
 	cmc_engines_init();
 }
 
+// start over from the static budgets, once engine settings changed their serialized sizes
+void
+cmc_engines_resize(void)
+{
+	uint_fast8_t e;
+
+	for(e=0; e<ENGINE_MAX; e++)
+	{
+		engines_head[e] = FRAME_BUFSIZE/2;
+		engines_blob[e] = BLOB_BUFSIZE;
+		engines_tail[e] = FRAME_BUFSIZE/2;
+	}
+}
+
 void
 cmc_engines_update(void)
 {
+	uint_fast8_t fanout [OUTPUT_FANOUT_MAX+1] = { 1 }; // usable destinations
+#if OUTPUT_FANOUT_MAX > 0
+	uint_fast8_t f;
+
+	for(f=0; f<OUTPUT_FANOUT_MAX; f++)
+		fanout[f+1] = config.output.fanout[f].enabled && (config.output.osc.mode == OSC_MODE_UDP);
+#endif
+
 	cmc_engines_active = 0;
 
+	// engines may move to other slots, forget what has been sent to them
+	uint_fast8_t b;
+	for(b=0; b<BLOB_MAX; b++)
+	{
+		memset(blobs[0][b].sent, 0xff, sizeof(blobs[0][b].sent)); // CMC_SENT_NONE
+		memset(blobs[1][b].sent, 0xff, sizeof(blobs[1][b].sent));
+	}
+
 	if(config.oscmidi.enabled)
+	{
+		engines_deltas[cmc_engines_active] = &config.oscmidi.deltas;
+		engines_decimation[cmc_engines_active] = &config.oscmidi.decimation;
+		engines_dest[cmc_engines_active] = config.oscmidi.destination;
 		engines[cmc_engines_active++] = &oscmidi_engine;
+	}
 
 	if(config.dummy.enabled)
+	{
+		engines_deltas[cmc_engines_active] = &config.dummy.deltas;
+		engines_decimation[cmc_engines_active] = &config.dummy.decimation;
+		engines_dest[cmc_engines_active] = config.dummy.destination;
 		engines[cmc_engines_active++] = &dummy_engine;
+	}
 
 	if(config.scsynth.enabled)
+	{
+		engines_deltas[cmc_engines_active] = &config.scsynth.deltas;
+		engines_decimation[cmc_engines_active] = &config.scsynth.decimation;
+		engines_dest[cmc_engines_active] = config.scsynth.destination;
 		engines[cmc_engines_active++] = &scsynth_engine;
+	}
 
 	if(config.tuio2.enabled)
+	{
+		engines_deltas[cmc_engines_active] = &config.tuio2.deltas;
+		engines_decimation[cmc_engines_active] = &config.tuio2.decimation;
+		engines_dest[cmc_engines_active] = config.tuio2.destination;
 		engines[cmc_engines_active++] = &tuio2_engine;
+	}
 
 	if(config.tuio1.enabled)
+	{
+		engines_deltas[cmc_engines_active] = &config.tuio1.deltas;
+		engines_decimation[cmc_engines_active] = &config.tuio1.decimation;
+		engines_dest[cmc_engines_active] = config.tuio1.destination;
 		engines[cmc_engines_active++] = &tuio1_engine;
+	}
 
 	if(config.custom.enabled)
+	{
+		engines_deltas[cmc_engines_active] = &config.custom.deltas;
+		engines_decimation[cmc_engines_active] = &config.custom.decimation;
+		engines_dest[cmc_engines_active] = config.custom.destination;
 		engines[cmc_engines_active++] = &custom_engine;
+	}
 
 	engines[cmc_engines_active] = NULL;
+
+	cmc_engines_resize(); // serialized sizes depend on engine order
+
+	// route engines of unusable destinations to the output socket
+	uint_fast8_t e;
+	memset(cmc_dest_engines, 0, sizeof(cmc_dest_engines));
+	for(e=0; e<cmc_engines_active; e++)
+	{
+		if( (engines_dest[e] > OUTPUT_FANOUT_MAX) || !fanout[engines_dest[e]])
+			engines_dest[e] = 0;
+		cmc_dest_engines[engines_dest[e]]++;
+	}
 }
@@ -24,6 +24,9 @@
 #define POLE_SOUTH 0
 
 #define ENGINE_MAX 6 // tuio1, tuio2, scsynth, oscmidi, dummy, custom
+#define CMC_SENT_NONE 0xffff // out of the Q15 range of positions, never within tolerance
+
+#define CMC_GATE 0.1f // maximal displacement of a blob between two cycles, relative to array length
 
 typedef enum {
 	CMC_BLOB_INVALID,
@@ -35,6 +38,7 @@ typedef enum {
 } CMC_Blob_State;
 
 typedef struct _CMC_Filt CMC_Filt;
+typedef struct _CMC_Pred CMC_Pred;
 typedef struct _CMC_Blob CMC_Blob;
 
 struct _CMC_Filt {
@@ -42,13 +46,24 @@ struct _CMC_Filt {
 	float f11;
 };
 
+struct _CMC_Pred {
+	float p; // filtered position
+	float v; // filtered velocity
+	float a; // filtered acceleration
+};
+
 struct _CMC_Blob {
 	uint32_t sid;
 	CMC_Group *group;
 	float x, y;
+	uint16_t sent [ENGINE_MAX][2]; // position last sent to each engine slot in Q15, CMC_SENT_NONE when unknown
 	CMC_Filt vx, vy;
 	float v, m;
+	CMC_Pred px, py;
+	float t; // acquisition time relative to frame timestamp
+	float rate; // update rate since related blob of previous cycle
 	uint16_t pid;
+	uint8_t peak; // sensor index of peak
 	uint8_t above_thresh;
 	CMC_Blob_State state;
 };
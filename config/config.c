@@ -15,6 +15,7 @@
  * http://www.perlfoundation.org/artistic_license_2_0.
  */
 
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
@@ -63,6 +64,7 @@ Config config = {
 		.minor = VERSION_MINOR,
 		.patch = VERSION_PATCH
 	},
+	.size = sizeof(Config),
 
 	.name = {'c', 'h', 'i', 'm', 'a', 'e', 'r', 'a', '\0'},
 
@@ -76,21 +78,33 @@ Config config = {
 
 	.tuio2 = {
 		.enabled = 0,
-		.derivatives = 0
+		.derivatives = 0,
+		.deltas = 0,
+		.decimation = 1,
+		.destination = 0
 	},
 
 	.tuio1 = {
 		.enabled = 0,
-		.custom_profile = 0
+		.custom_profile = 0,
+		.deltas = 0,
+		.decimation = 1,
+		.destination = 0
 	},
 
 	.dump = {
-		.enabled = 0
+		.enabled = 0,
+		.encoding = DUMP_ENCODING_RAW,
+		.decimation = 1,
+		.window = 0
 	},
 
 	.scsynth = {
 		.enabled = 0,
-		.derivatives = 0
+		.derivatives = 0,
+		.deltas = 0,
+		.decimation = 1,
+		.destination = 0
 	},
 
 	.oscmidi = {
@@ -98,17 +112,26 @@ Config config = {
 		.multi = 1,
 		.format = OSC_MIDI_FORMAT_MIDI,
 		.mpe = 0,
+		.deltas = 0,
+		.decimation = 1,
+		.destination = 0,
 		.path = {'/', 'm', 'i', 'd', 'i', '\0'}
 	},
 
 	.dummy = {
 		.enabled = 0,
 		.redundancy = 0,
-		.derivatives = 0
+		.derivatives = 0,
+		.deltas = 0,
+		.decimation = 1,
+		.destination = 0
 	},
 
 	.custom = {
 		.enabled = 0,
+		.deltas = 0,
+		.decimation = 1,
+		.destination = 0,
 		/*
 		.items = {
 			[0] = {
@@ -137,7 +160,27 @@ Config config = {
 			.x = 0,
 			.z = 0
 		},
-		.parallel = 1
+		.parallel = 1,
+		.keepalive = 32,
+		.tolerance = 0.002f,
+		.fanout = {
+#if OUTPUT_FANOUT_MAX > 0
+			[0] = {
+				.sock = SOCK_OUTPUT,
+				.enabled = 0,
+				.port = {3333, 3334},
+				.ip = IP_BROADCAST
+			},
+#endif
+#if OUTPUT_FANOUT_MAX > 1
+			[1] = {
+				.sock = SOCK_OUTPUT,
+				.enabled = 0,
+				.port = {3333, 3335},
+				.ip = IP_BROADCAST
+			}
+#endif
+		}
 	},
 
 	.config = {
@@ -217,10 +260,26 @@ Config config = {
 	},
 
 	.sensors = {
-		.movingaverage_bitshift = 3,
+		.smoothing = 0x1000, // := 1/8, the former 8 sample moving average
 		.interpolation_mode = INTERPOLATION_QUADRATIC,
 		.velocity_stiffness = 32,
-		.rate = 2000
+		.prediction = 0,
+		.pipelined = 0,
+		.oversampling = 1,
+		.roi = {
+			.enabled = 0,
+			.interval = 8
+		},
+		.rate = 2000,
+		.governor = {
+			.enabled = 0,
+			.min = 100
+		},
+		.health = {
+			.enabled = 0,
+			.feed = 0,
+			.bound = 48 // := 3 LSB
+		}
 	},
 
 	// we only define attributes for two groups for factory settings
@@ -342,17 +401,22 @@ CONFIG_SEND(uint16_t size)
 	osc_send(&config.config.osc, BUF_O_BASE(buf_o_ptr), size);
 }
 
+_Static_assert(sizeof(Config) <= EEPROM_RANGE_OFFSET - EEPROM_CONFIG_OFFSET, "Config overlaps calibration in EEPROM");
+
 uint_fast8_t
 version_match()
 {
 	Firmware_Version version;
+	uint16_t size;
 	eeprom_bulk_read(eeprom_24LC64, EEPROM_CONFIG_OFFSET,(uint8_t *)&version, sizeof(Firmware_Version));
+	eeprom_bulk_read(eeprom_24LC64, EEPROM_CONFIG_OFFSET + offsetof(Config, size),(uint8_t *)&size, sizeof(size));
 
-	// check whether EEPROM and FLASH version numbers match
+	// check whether EEPROM and FLASH version numbers and config layouts match
 	// board revision is excluded from the check
 	return(version.major == config.version.major)
 		&& (version.minor == config.version.minor)
-		&& (version.patch == config.version.patch);
+		&& (version.patch == config.version.patch)
+		&& (size == sizeof(Config));
 }
 
 uint_fast8_t
@@ -556,7 +620,13 @@ _config_load(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *b
 	buf_ptr = osc_get_int32(buf_ptr, &uuid);
 
 	if(config_load())
+	{
+		cmc_group_update(); // reinitialize engines (e.g. cached OSC templates)
+		cmc_velocity_stiffness_update(config.sensors.velocity_stiffness);
+		cmc_prediction_update(config.sensors.prediction);
+		cmc_interpolation_update(config.sensors.interpolation_mode);
 		size = CONFIG_SUCCESS("is", uuid, path);
+	}
 	else
 		size = CONFIG_FAIL("iss", uuid, path, "loading of configuration from EEPROM failed");
 
@@ -808,6 +878,7 @@ _output_mode(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *b
 				break;
 			}
 		output_enable(enabled);
+		cmc_engines_update(); // fan-out needs UDP mode
 		size = CONFIG_SUCCESS("is", uuid, path);
 	}
 
@@ -836,6 +907,7 @@ struct _Address_Cb {
 	int32_t uuid;
 	char path [ADDRESS_CB_LEN];
 	Socket_Config *socket;
+	Socket_Enable_Cb cb; // reopens socket with new address
 	uint16_t port;
 };
 
@@ -851,8 +923,8 @@ _address_dns_cb(uint8_t *ip, void *data)
 	{
 		socket->port[DST_PORT] = address_cb->port;
 		memcpy(socket->ip, ip, 4);
-		Socket_Enable_Cb cb = socket_callbacks[socket->sock];
-		cb(socket->enabled);
+		if(address_cb->cb)
+			address_cb->cb(socket->enabled);
 
 		ip2str(ip, string_buf);
 		DEBUG("ss", "_address_dns_cb", string_buf);
@@ -865,8 +937,8 @@ _address_dns_cb(uint8_t *ip, void *data)
 	CONFIG_SEND(size);
 }
 
-uint_fast8_t
-config_address(Socket_Config *socket, const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+static uint_fast8_t
+_config_address(Socket_Config *socket, Socket_Enable_Cb cb, const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
 	(void)fmt;
 	osc_data_t *buf_ptr = buf;
@@ -891,6 +963,7 @@ config_address(Socket_Config *socket, const char *path, const char *fmt, uint_fa
 		address_cb.uuid = uuid;
 		strncpy(address_cb.path, path, ADDRESS_CB_LEN-1);
 		address_cb.socket = socket;
+		address_cb.cb = cb;
 
 		if(!strncmp(hostname, "this", 4)) // set IP to requesting IP
 		{
@@ -929,6 +1002,12 @@ config_address(Socket_Config *socket, const char *path, const char *fmt, uint_fa
 	return 1;
 }
 
+uint_fast8_t
+config_address(Socket_Config *socket, const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _config_address(socket, socket_callbacks[socket->sock], path, fmt, argc, buf);
+}
+
 static uint_fast8_t
 _config_mode(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
@@ -1070,6 +1149,43 @@ _output_parallel(const char *path, const char *fmt, uint_fast8_t argc, osc_data_
 	return config_check_bool(path, fmt, argc, buf, &config.output.parallel);
 }
 
+#if OUTPUT_FANOUT_MAX > 0
+#define OUTPUT_FANOUT(PATH) \
+({ \
+	uint16_t _d = 0; \
+	sscanf(PATH, "/engines/fanout/%hu/", &_d); \
+	(&config.output.fanout[_d]); \
+})
+
+static uint_fast8_t
+_output_fanout_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	Socket_Config *fanout = OUTPUT_FANOUT(path);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &fanout->enabled);
+	cmc_engines_update();
+	return res;
+}
+
+static uint_fast8_t
+_output_fanout_address(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	Socket_Config *fanout = OUTPUT_FANOUT(path);
+	return _config_address(fanout, NULL, path, fmt, argc, buf); // remote is set before each send
+}
+#endif
+
+static uint_fast8_t
+_output_keepalive(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint16(path, fmt, argc, buf, &config.output.keepalive);
+}
+
+static uint_fast8_t
+_output_tolerance(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_float(path, fmt, argc, buf, &config.output.tolerance);
+}
+
 static uint_fast8_t
 _reset_soft(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
@@ -1174,6 +1290,14 @@ const OSC_Query_Argument config_boolean_args [] = {
 	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
 };
 
+const OSC_Query_Argument config_decimation_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Frames", OSC_QUERY_MODE_RW, 1, 255, 1)
+};
+
+const OSC_Query_Argument config_destination_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Output socket (0) or fan-out (1..)", OSC_QUERY_MODE_RW, 0, OUTPUT_FANOUT_MAX, 1)
+};
+
 const OSC_Query_Argument config_address_args [] = {
 	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted or mDNS .local domain with colon and port", OSC_QUERY_MODE_RW, 64)
 };
@@ -1241,6 +1365,25 @@ static const OSC_Query_Argument engines_invert_args [] = {
 	OSC_QUERY_ARGUMENT_BOOL("axis inversion", OSC_QUERY_MODE_RW)
 };
 
+static const OSC_Query_Argument engines_keepalive_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Frames", OSC_QUERY_MODE_RW, 0, 0xffff, 1)
+};
+
+static const OSC_Query_Argument engines_tolerance_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Distance", OSC_QUERY_MODE_RW, 0.f, 0.1f, 0.0001f)
+};
+
+#if OUTPUT_FANOUT_MAX > 0
+static const OSC_Query_Item engines_fanout_tree [] = {
+	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _output_fanout_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("address", "Remote host", _output_fanout_address, config_address_args),
+};
+
+static const OSC_Query_Item engines_fanout_array [] = {
+	OSC_QUERY_ITEM_NODE("%i/", "Destination", engines_fanout_tree)
+};
+#endif
+
 static const OSC_Query_Item engines_tree [] = {
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _output_enabled, config_boolean_args),
 	OSC_QUERY_ITEM_METHOD("address", "Single remote host", _output_address, config_address_args),
@@ -1248,9 +1391,14 @@ static const OSC_Query_Item engines_tree [] = {
 	OSC_QUERY_ITEM_METHOD("invert_x", "Enable/disable x-axis inversion", _output_invert_x, engines_invert_args),
 	OSC_QUERY_ITEM_METHOD("invert_z", "Enable/disable z-axis inversion", _output_invert_z, engines_invert_args),
 	OSC_QUERY_ITEM_METHOD("parallel", "Parallel processing", _output_parallel, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("keepalive", "Full update interval for delta engines", _output_keepalive, engines_keepalive_args),
+	OSC_QUERY_ITEM_METHOD("tolerance", "Still blob tolerance for delta engines", _output_tolerance, engines_tolerance_args),
 	OSC_QUERY_ITEM_METHOD("reset", "Disable all engines", _output_reset, NULL),
 	OSC_QUERY_ITEM_METHOD("mode", "Enable/disable UDP/TCP mode", _output_mode, config_mode_args),
 	OSC_QUERY_ITEM_METHOD("server", "Enable/disable TCP server mode", _output_server, config_boolean_args),
+#if OUTPUT_FANOUT_MAX > 0
+	OSC_QUERY_ITEM_ARRAY("fanout/", "Additional UDP destinations", engines_fanout_array, OUTPUT_FANOUT_MAX),
+#endif
 
 	// engines
 	OSC_QUERY_ITEM_NODE("dump/", "Dump output engine", dump_tree),
@@ -42,10 +42,13 @@ custom_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 	osc_data_t *buf_ptr = buf;
 	osc_data_t *itm;
 
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &pack);
 	buf_ptr = osc_start_bundle(buf_ptr, end, fev->offset, &bndl);
 
+	if(fev->split) // frame items went out with the first part of the frame
+		return buf_ptr;
+
 	uint_fast8_t i;
 	Custom_Item *item;
 	if(fev->nblob_old + fev->nblob_new)
@@ -95,32 +98,32 @@ custom_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 static osc_data_t *
 custom_engine_end_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
-	(void)fev;
 	osc_data_t *buf_ptr = buf;
 	osc_data_t *itm;
 
 	uint_fast8_t i;
 	Custom_Item *item;
-	for(i=0; i<CUSTOM_MAX_EXPR; i++)
-	{
-		item = &items[i];
-		if(item->dest == RPN_END)
+	if(!fev->split) // end items go out with the last part of the frame
+		for(i=0; i<CUSTOM_MAX_EXPR; i++)
 		{
-			buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
+			item = &items[i];
+			if(item->dest == RPN_END)
 			{
-				buf_ptr = osc_set_path(buf_ptr, end, item->path);
-				buf_ptr = osc_set_fmt(buf_ptr, end, item->fmt);
+				buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
+				{
+					buf_ptr = osc_set_path(buf_ptr, end, item->path);
+					buf_ptr = osc_set_fmt(buf_ptr, end, item->fmt);
 
-				buf_ptr = rpn_run(buf_ptr, end, item, &stack);
+					buf_ptr = rpn_run(buf_ptr, end, item, &stack);
+				}
+				buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 			}
-			buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
+			else if(item->dest == RPN_NONE)
+				break;
 		}
-		else if(item->dest == RPN_NONE)
-			break;
-	}
 
 	buf_ptr = osc_end_bundle(buf_ptr, end, bndl);
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_end_bundle_item(buf_ptr, end, pack);
 
 	return buf_ptr;
@@ -255,6 +258,26 @@ _custom_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t
 	return res;
 }
 
+static uint_fast8_t
+_custom_deltas(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.custom.deltas);
+}
+
+static uint_fast8_t
+_custom_decimation(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint8(path, fmt, argc, buf, &config.custom.decimation);
+}
+
+static uint_fast8_t
+_custom_destination(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.custom.destination);
+	cmc_engines_update();
+	return res;
+}
+
 static uint_fast8_t
 _custom_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
@@ -279,6 +302,7 @@ _custom_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *
 
 	size = CONFIG_SUCCESS("is", uuid, path);
 	CONFIG_SEND(size);
+	cmc_engines_resize();
 	return 1;
 }
 
@@ -331,6 +355,7 @@ _custom_append(int dest, const char *path, const char *fmt, uint_fast8_t argc, o
 
 	CONFIG_SEND(size);
 
+	cmc_engines_resize();
 	return 1;
 }
 
@@ -389,6 +414,9 @@ const OSC_Query_Item custom_append_tree [] = {
 
 const OSC_Query_Item custom_tree [] = {
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _custom_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("deltas", "Only send changed blobs", _custom_deltas, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("decimation", "Update blobs every Nth frame", _custom_decimation, config_decimation_args),
+	OSC_QUERY_ITEM_METHOD("destination", "Output destination", _custom_destination, config_destination_args),
 	OSC_QUERY_ITEM_METHOD("reset", "Reset", _custom_reset, NULL),
 	OSC_QUERY_ITEM_NODE("append/", "Append hook", custom_append_tree),
 };
@@ -47,16 +47,36 @@ static const char *dummy_set_fmt [2][2] = {
 	}
 };
 
+static OSC_Template dummy_idle_tmpl;
+static OSC_Template dummy_on_tmpl;
+static OSC_Template dummy_off_tmpl [2];
+static OSC_Template dummy_set_tmpl [2][2];
+
 static osc_data_t *pack;
 static osc_data_t *bndl;
 
+static void
+dummy_init(void)
+{
+	uint_fast8_t r, d;
+
+	osc_template_init(&dummy_idle_tmpl, dummy_idle_str, dummy_idle_fmt);
+	osc_template_init(&dummy_on_tmpl, dummy_on_str, dummy_on_fmt);
+	for(r=0; r<2; r++)
+	{
+		osc_template_init(&dummy_off_tmpl[r], dummy_off_str, dummy_off_fmt[r]);
+		for(d=0; d<2; d++)
+			osc_template_init(&dummy_set_tmpl[r][d], dummy_set_str, dummy_set_fmt[r][d]);
+	}
+}
+
 static osc_data_t *
 dummy_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
 	osc_data_t *buf_ptr = buf;
 	osc_data_t *itm;
 
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &pack);
 	buf_ptr = osc_start_bundle(buf_ptr, end, fev->offset, &bndl);
 
@@ -64,8 +84,7 @@ dummy_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 	{
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 		{
-			buf_ptr = osc_set_path(buf_ptr, end, dummy_idle_str);
-			buf_ptr = osc_set_fmt(buf_ptr, end, dummy_idle_fmt);
+			buf_ptr = osc_set_template(buf_ptr, end, &dummy_idle_tmpl);
 		}
 		buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 	}
@@ -76,11 +95,10 @@ dummy_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 static osc_data_t *
 dummy_engine_end_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
-	(void)fev;
 	osc_data_t *buf_ptr = buf;
 
 	buf_ptr = osc_end_bundle(buf_ptr, end, bndl);
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_end_bundle_item(buf_ptr, end, pack);
 
 	return buf_ptr;
@@ -94,13 +112,12 @@ dummy_engine_on_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, dummy_on_str);
-		buf_ptr = osc_set_fmt(buf_ptr, end, dummy_on_fmt);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->sid);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->gid);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->pid);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->x);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->y);
+		buf_ptr = osc_set_template(buf_ptr, end, &dummy_on_tmpl);
+		buf_ptr = osc_put_int32(buf_ptr, bev->sid);
+		buf_ptr = osc_put_int32(buf_ptr, bev->gid);
+		buf_ptr = osc_put_int32(buf_ptr, bev->pid);
+		buf_ptr = osc_put_float(buf_ptr, bev->x);
+		buf_ptr = osc_put_float(buf_ptr, bev->y);
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 
@@ -116,13 +133,12 @@ dummy_engine_off_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, dummy_off_str);
-		buf_ptr = osc_set_fmt(buf_ptr, end, dummy_off_fmt[redundancy]);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->sid);
+		buf_ptr = osc_set_template(buf_ptr, end, &dummy_off_tmpl[redundancy]);
+		buf_ptr = osc_put_int32(buf_ptr, bev->sid);
 		if(redundancy)
 		{
-			buf_ptr = osc_set_int32(buf_ptr, end, bev->gid);
-			buf_ptr = osc_set_int32(buf_ptr, end, bev->pid);
+			buf_ptr = osc_put_int32(buf_ptr, bev->gid);
+			buf_ptr = osc_put_int32(buf_ptr, bev->pid);
 		}
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
@@ -140,20 +156,19 @@ dummy_engine_set_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, dummy_set_str);
-		buf_ptr = osc_set_fmt(buf_ptr, end, dummy_set_fmt[redundancy][derivatives]);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->sid);
+		buf_ptr = osc_set_template(buf_ptr, end, &dummy_set_tmpl[redundancy][derivatives]);
+		buf_ptr = osc_put_int32(buf_ptr, bev->sid);
 		if(redundancy)
 		{
-			buf_ptr = osc_set_int32(buf_ptr, end, bev->gid);
-			buf_ptr = osc_set_int32(buf_ptr, end, bev->pid);
+			buf_ptr = osc_put_int32(buf_ptr, bev->gid);
+			buf_ptr = osc_put_int32(buf_ptr, bev->pid);
 		}
-		buf_ptr = osc_set_float(buf_ptr, end, bev->x);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->y);
+		buf_ptr = osc_put_float(buf_ptr, bev->x);
+		buf_ptr = osc_put_float(buf_ptr, bev->y);
 		if(derivatives)
 		{
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vx);
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vy);
+			buf_ptr = osc_put_float(buf_ptr, bev->vx);
+			buf_ptr = osc_put_float(buf_ptr, bev->vy);
 		}
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
@@ -162,7 +177,7 @@ dummy_engine_set_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 }
 
 CMC_Engine dummy_engine = {
-	NULL,
+	dummy_init,
 	dummy_engine_frame_cb,
 	dummy_engine_on_cb,
 	dummy_engine_off_cb,
@@ -181,16 +196,40 @@ _dummy_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t
 	return res;
 }
 
+static uint_fast8_t
+_dummy_deltas(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.dummy.deltas);
+}
+
+static uint_fast8_t
+_dummy_decimation(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint8(path, fmt, argc, buf, &config.dummy.decimation);
+}
+
+static uint_fast8_t
+_dummy_destination(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.dummy.destination);
+	cmc_engines_update();
+	return res;
+}
+
 static uint_fast8_t
 _dummy_redundancy(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
-	return config_check_bool(path, fmt, argc, buf, &config.dummy.redundancy);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.dummy.redundancy);
+	cmc_engines_resize();
+	return res;
 }
 
 static uint_fast8_t
 _dummy_derivatives(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
-	return config_check_bool(path, fmt, argc, buf, &config.dummy.derivatives);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.dummy.derivatives);
+	cmc_engines_resize();
+	return res;
 }
 
 /*
@@ -199,6 +238,9 @@ _dummy_derivatives(const char *path, const char *fmt, uint_fast8_t argc, osc_dat
 
 const OSC_Query_Item dummy_tree [] = {
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _dummy_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("deltas", "Only send changed blobs", _dummy_deltas, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("decimation", "Update blobs every Nth frame", _dummy_decimation, config_decimation_args),
+	OSC_QUERY_ITEM_METHOD("destination", "Output destination", _dummy_destination, config_destination_args),
 	OSC_QUERY_ITEM_METHOD("redundancy", "Send redundant data", _dummy_redundancy, config_boolean_args),
 	OSC_QUERY_ITEM_METHOD("derivatives", "Calculate derivatives", _dummy_derivatives, config_boolean_args)
 };
@@ -15,40 +15,218 @@
  * http://www.perlfoundation.org/artistic_license_2_0.
  */
 
+#include <string.h>
+
 #include <chimaera.h>
 #include <config.h>
 
 #include <dump.h>
 
 static const char *dump_str = "/dump";
-static const char *dump_fmt = "ib";
+static const char *dump_fmt = "ibt";
+static const char *dump_fmt_header = "ibti";
+static const char *dump_roi_str = "/dump/roi";
+
+static uint8_t win_start [BLOB_MAX]; // first sensor of each window
+static uint8_t win_len [BLOB_MAX]; // ^number of sensors
 
 static uint32_t frame = 0;
+static uint_fast8_t phase = 0; // frames since last dumped one
+static uint_fast8_t key = 0; // dumped frames since last delta keyframe
+
+uint_fast8_t
+dump_frame(void)
+{
+	if(++phase < config.dump.decimation)
+		return DUMP_FRAME_SKIP;
+	phase = 0;
+
+	switch(config.dump.encoding)
+	{
+		case DUMP_ENCODING_INT8:
+			return DUMP_FRAME_INT8;
+		case DUMP_ENCODING_DELTA:
+			if(config.dump.window) // windows move, thus there is no common reference
+				return DUMP_FRAME_KEY;
+			if(key++ == 0)
+				return DUMP_FRAME_KEY;
+			if(key >= DUMP_KEYFRAME_INTERVAL)
+				key = 0;
+			return DUMP_FRAME_DELTA;
+		default:
+			return DUMP_FRAME_RAW;
+	}
+}
+
+// pack zig-zag encoded values into LEB128 varints in place, 12-bit sensor
+// values bound them to 14 bits, e.g. never more than the two bytes they are read from
+static inline int32_t
+_varint_pack(int16_t *swap, uint_fast8_t n)
+{
+	const uint16_t *src = (const uint16_t *)swap;
+	uint8_t *dst = (uint8_t *)swap;
+	uint_fast8_t i;
+
+	for(i=0; i<n; i++)
+	{
+		uint16_t z = src[i];
+		while(z >= 0x80)
+		{
+			*dst++ = (z & 0x7f) | 0x80;
+			z >>= 7;
+		}
+		*dst++ = z;
+	}
+
+	return dst - (uint8_t *)swap;
+}
+
+// merge windows around the peaks of tracked blobs
+static uint_fast8_t
+_window_plan(void)
+{
+	uint8_t peaks [BLOB_MAX];
+	uint_fast8_t n = cmc_engines_active ? cmc_blob_peaks(peaks) : 0;
+	uint_fast8_t n_win = 0;
+	uint_fast8_t i, j;
+
+	for(i=1; i<n; i++) // peaks are in order of x, which may be inverted
+		for(j=i; (j>0) && (peaks[j-1] > peaks[j]); j--)
+		{
+			uint8_t tmp = peaks[j];
+			peaks[j] = peaks[j-1];
+			peaks[j-1] = tmp;
+		}
+
+	for(i=0; i<n; i++)
+	{
+		int16_t start = peaks[i] - config.dump.window;
+		int16_t stop = peaks[i] + config.dump.window + 1;
+		if(start < 0)
+			start = 0;
+		if(stop > SENSOR_N)
+			stop = SENSOR_N;
+
+		if(n_win && (start <= win_start[n_win-1] + win_len[n_win-1]) ) // overlaps or adjoins previous window
+			win_len[n_win-1] = stop - win_start[n_win-1];
+		else
+		{
+			win_start[n_win] = start;
+			win_len[n_win] = stop - start;
+			n_win++;
+		}
+	}
+
+	return n_win;
+}
+
+// gather windows at the start of the dump staging buffer, returns number of sensors
+static uint_fast8_t
+_window_gather(int16_t *swap, uint_fast8_t n_win, size_t size)
+{
+	uint8_t *dst = (uint8_t *)swap;
+	uint_fast8_t n = 0;
+	uint_fast8_t w;
+
+	for(w=0; w<n_win; w++)
+	{
+		memmove(dst, (uint8_t *)swap + win_start[w]*size, win_len[w]*size); // windows are ascending, dst never overtakes src
+		dst += win_len[w]*size;
+		n += win_len[w];
+	}
+
+	return n;
+}
 
 osc_data_t *
-dump_update(osc_data_t *buf, osc_data_t *end, OSC_Timetag now, OSC_Timetag offset, int32_t len, int16_t *swap)
+dump_update(osc_data_t *buf, osc_data_t *end, OSC_Timetag now, OSC_Timetag offset, uint_fast8_t frm, int16_t *swap)
 {
-	(void)now;
 	osc_data_t *buf_ptr = buf;
 	osc_data_t *itm;
 	osc_data_t *pack = NULL;
 	osc_data_t *bndl;
+	uint32_t header = (config.dump.decimation << 16) | (DUMP_INT8_SHIFT << 8);
+	uint_fast8_t n = SENSOR_N;
+	uint_fast8_t n_win = 0;
+	int32_t len;
+
+	if(config.dump.window)
+	{
+		header |= DUMP_HEADER_WINDOW;
+		n_win = _window_plan();
+		n = _window_gather(swap, n_win, frm == DUMP_FRAME_INT8 ? sizeof(int8_t) : sizeof(int16_t));
+	}
+
+	switch(frm)
+	{
+		case DUMP_FRAME_INT8:
+			header |= DUMP_ENCODING_INT8;
+			len = n * sizeof(int8_t);
+			break;
+		case DUMP_FRAME_DELTA:
+			header |= DUMP_ENCODING_DELTA;
+			len = _varint_pack(swap, n);
+			break;
+		case DUMP_FRAME_KEY:
+			header |= DUMP_ENCODING_DELTA | DUMP_HEADER_KEYFRAME;
+			len = _varint_pack(swap, n);
+			break;
+		default: // DUMP_FRAME_RAW
+			header |= DUMP_ENCODING_RAW;
+			len = n * sizeof(int16_t);
+			break;
+	}
+
+	++frame;
 
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(cmc_dest_engines[0] + config.dump.enabled > 1)
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &pack);
 	buf_ptr = osc_start_bundle(buf_ptr, end, offset, &bndl);
 
+	if(config.dump.window)
+	{
+		char fmt [2 + 2*BLOB_MAX];
+		uint_fast8_t w;
+
+		fmt[0] = 'i';
+		for(w=0; w<n_win; w++)
+		{
+			fmt[1 + 2*w] = 'i';
+			fmt[2 + 2*w] = 'i';
+		}
+		fmt[1 + 2*n_win] = '\0';
+
+		buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
+		{
+			buf_ptr = osc_set_path(buf_ptr, end, dump_roi_str);
+			buf_ptr = osc_set_fmt(buf_ptr, end, fmt);
+			buf_ptr = osc_set_int32(buf_ptr, end, frame);
+			for(w=0; w<n_win; w++)
+			{
+				buf_ptr = osc_set_int32(buf_ptr, end, win_start[w]);
+				buf_ptr = osc_set_int32(buf_ptr, end, win_len[w]);
+			}
+		}
+		buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
+	}
+
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
+		// plain raw frames stay header-less for compatibility with older receivers
+		uint_fast8_t plain = (frm == DUMP_FRAME_RAW) && (config.dump.decimation <= 1) && !config.dump.window;
+
 		buf_ptr = osc_set_path(buf_ptr, end, dump_str);
-		buf_ptr = osc_set_fmt(buf_ptr, end, dump_fmt);
-		buf_ptr = osc_set_int32(buf_ptr, end, ++frame);
+		buf_ptr = osc_set_fmt(buf_ptr, end, plain ? dump_fmt : dump_fmt_header);
+		buf_ptr = osc_set_int32(buf_ptr, end, frame);
 		buf_ptr = osc_set_blob(buf_ptr, end, len, swap);
+		buf_ptr = osc_set_timetag(buf_ptr, end, now); // acquisition time, needed for capture replay
+		if(!plain)
+			buf_ptr = osc_set_int32(buf_ptr, end, header);
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 
 	buf_ptr = osc_end_bundle(buf_ptr, end, bndl);
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(cmc_dest_engines[0] + config.dump.enabled > 1)
 		buf_ptr = osc_end_bundle_item(buf_ptr, end, pack);
 
 	return buf_ptr;
@@ -61,14 +239,85 @@ static uint_fast8_t
 _dump_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
 	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.dump.enabled);
+	key = 0; // delta reference is stale
 	cmc_engines_update();
 	return res;
 }
 
+static const OSC_Query_Value dump_encoding_args_values [] = {
+	[DUMP_ENCODING_RAW]			= { .s = "raw" },
+	[DUMP_ENCODING_INT8]		= { .s = "int8" },
+	[DUMP_ENCODING_DELTA]		= { .s = "delta" },
+};
+
+static uint_fast8_t
+_dump_encoding(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size = 0;
+	uint8_t *encoding = &config.dump.encoding;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc == 1)
+		size = CONFIG_SUCCESS("iss", uuid, path, dump_encoding_args_values[*encoding].s);
+	else
+	{
+		uint_fast8_t i;
+		const char *s;
+		buf_ptr = osc_get_string(buf_ptr, &s);
+		for(i=0; i<sizeof(dump_encoding_args_values)/sizeof(OSC_Query_Value); i++)
+			if(!strcmp(s, dump_encoding_args_values[i].s))
+			{
+				*encoding = i;
+				key = 0; // start new encoding with a keyframe
+				break;
+			}
+		size = CONFIG_SUCCESS("is", uuid, path);
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_dump_decimation(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint8(path, fmt, argc, buf, &config.dump.decimation);
+}
+
+static uint_fast8_t
+_dump_window(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.dump.window);
+	if(config.dump.window > DUMP_WINDOW_MAX)
+		config.dump.window = DUMP_WINDOW_MAX;
+	key = 0; // delta reference is stale
+	return res;
+}
+
 /*
  * Query
  */
 
+static const OSC_Query_Argument dump_encoding_args [] = {
+	OSC_QUERY_ARGUMENT_STRING_VALUES("Encoding", OSC_QUERY_MODE_RW, dump_encoding_args_values)
+};
+
+static const OSC_Query_Argument dump_decimation_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Frames", OSC_QUERY_MODE_RW, 1, 255, 1)
+};
+
+static const OSC_Query_Argument dump_window_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Sensors", OSC_QUERY_MODE_RW, 0, DUMP_WINDOW_MAX, 1)
+};
+
 const OSC_Query_Item dump_tree [] = {
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _dump_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("encoding", "Blob encoding", _dump_encoding, dump_encoding_args),
+	OSC_QUERY_ITEM_METHOD("decimation", "Dump 1 of N frames", _dump_decimation, dump_decimation_args),
+	OSC_QUERY_ITEM_METHOD("window", "Half width of windows around tracked blobs, 0 for whole frames", _dump_window, dump_window_args),
 };
@@ -105,6 +105,6 @@ struct _Custom_Item {
 };
 
 extern CMC_Engine custom_engine;
-extern const OSC_Query_Item custom_tree [3];
+extern const OSC_Query_Item custom_tree [6];
 
 #endif // _CUSTOM_H_
@@ -22,6 +22,6 @@
 #include <oscquery.h>
 
 extern CMC_Engine dummy_engine;
-extern const OSC_Query_Item dummy_tree [3];
+extern const OSC_Query_Item dummy_tree [6];
 
 #endif // _DUMMY_H_
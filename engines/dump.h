@@ -21,8 +21,33 @@
 #include <cmc.h>
 #include <oscquery.h>
 
-extern const OSC_Query_Item dump_tree [1];
+#define DUMP_INT8_SHIFT 4 // 12-bit sensor values scaled down to 8-bit
+#define DUMP_KEYFRAME_INTERVAL 64 // dumped frames between delta keyframes
+#define DUMP_WINDOW_MAX 32 // maximal half width of windows around tracked blobs
 
-osc_data_t * dump_update(osc_data_t *buf, osc_data_t *end, OSC_Timetag now, OSC_Timetag offset, int32_t len, int16_t *swap);
+// encodings of the /dump blob, announced in the header argument
+enum _Dump_Encoding {
+	DUMP_ENCODING_RAW = 0, // big-endian int16
+	DUMP_ENCODING_INT8, // int8, scaled down by 2^DUMP_INT8_SHIFT
+	DUMP_ENCODING_DELTA // zig-zag LEB128 varint of the difference to the previous dumped frame
+};
+
+// header argument: bits 0-6 encoding, bit 7 keyframe, bits 8-15 int8 shift, bits 16-23 decimation, bit 24 windowed
+#define DUMP_HEADER_KEYFRAME 0x80
+#define DUMP_HEADER_WINDOW 0x1000000
+
+// per-frame work item for the sensor fill loop, as returned by dump_frame
+enum _Dump_Frame {
+	DUMP_FRAME_SKIP = 0,
+	DUMP_FRAME_RAW, // swap is filled with big-endian int16
+	DUMP_FRAME_INT8, // swap is filled with SENSOR_N int8
+	DUMP_FRAME_DELTA, // swap is filled with zig-zag encoded uint16 differences
+	DUMP_FRAME_KEY // as DUMP_FRAME_DELTA, but differences to zero
+};
+
+extern const OSC_Query_Item dump_tree [4];
+
+uint_fast8_t dump_frame(void);
+osc_data_t * dump_update(osc_data_t *buf, osc_data_t *end, OSC_Timetag now, OSC_Timetag offset, uint_fast8_t frm, int16_t *swap);
 
 #endif // _DUMP_H_
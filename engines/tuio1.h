@@ -22,6 +22,6 @@
 #include <oscquery.h>
 
 extern CMC_Engine tuio1_engine;
-extern const OSC_Query_Item tuio1_tree [2];
+extern const OSC_Query_Item tuio1_tree [5];
 
 #endif // _TUIO1_H_
@@ -57,21 +57,39 @@
 #include <sensors.h>
 //#include <osc.h>
 
+#define ADC_OVERSAMPLING_MAX 4 // maximal conversions per channel and mux step
+#define ADC_ROI_MARGIN 2 // sensors converted beyond areas of interest when scanning regions of interest
+
+// the regular sequence of at most 16 conversions holds the channels repeated for each oversample
+_Static_assert(ADC_DUAL_LENGTH*ADC_OVERSAMPLING_MAX <= 16, "ADC12 sequence too long for oversampling");
+_Static_assert(ADC_SING_LENGTH*ADC_OVERSAMPLING_MAX <= 16, "ADC3 sequence too long for oversampling");
+
 #if(ADC_DUAL_LENGTH > 0)
-static uint8_t adc1_raw_sequence [ADC_DUAL_LENGTH]; // ^corresponding raw ADC channels
-static uint8_t adc2_raw_sequence [ADC_DUAL_LENGTH]; // ^corresponding raw ADC channels
+static uint8_t adc1_raw_sequence [ADC_DUAL_LENGTH*ADC_OVERSAMPLING_MAX]; // ^corresponding raw ADC channels
+static uint8_t adc2_raw_sequence [ADC_DUAL_LENGTH*ADC_OVERSAMPLING_MAX]; // ^corresponding raw ADC channels
 #endif
 
 #if(ADC_SING_LENGTH > 0)
-static uint8_t adc3_raw_sequence [ADC_SING_LENGTH];
+static uint8_t adc3_raw_sequence [ADC_SING_LENGTH*ADC_OVERSAMPLING_MAX];
 #endif
 
-static int16_t adc12_raw[2][MUX_MAX*ADC_DUAL_LENGTH*2] __attribute__((aligned(4))); // the dma temporary data array.
-static int16_t adc3_raw[2][MUX_MAX*ADC_SING_LENGTH] __attribute__((aligned(4)));
+static int16_t adc12_raw[2][MUX_MAX*ADC_DUAL_LENGTH*2*ADC_OVERSAMPLING_MAX] __attribute__((aligned(4))); // the dma temporary data array.
+static int16_t adc3_raw[2][MUX_MAX*ADC_SING_LENGTH*ADC_OVERSAMPLING_MAX] __attribute__((aligned(4)));
 
-static int16_t adc_sum[SENSOR_N];
+static int32_t adc_iir[SENSOR_N]; // smoothed sensor values in Q15
+static int16_t adc_last[SENSOR_N]; // ^truncated to integer, as output in the previous frame
+static int16_t adc_alpha[SENSOR_N] __attribute__((aligned(4))); // per-sensor IIR coefficients in Q15
 static int16_t adc_rela[SENSOR_N];
-static int16_t adc_swap[SENSOR_N];
+static int16_t adc_swap[SENSOR_N] __attribute__((aligned(4))); // dump staging, encoded as of dump_frame
+static int16_t adc_dump_last[SENSOR_N] __attribute__((aligned(4))); // reference of delta encoded dump
+static CMC_Mask adc_mask; // areas of interest and polarity, produced alongside adc_rela
+static int64_t adc_mux_tick[2][MUX_MAX+1]; // uptime at start of each mux step and at end of sweep
+static uint8_t adc_roi_list[2][MUX_MAX]; // mux steps converted into consecutive slots of each raw buffer
+static uint8_t adc_roi_n[2] = {MUX_MAX, MUX_MAX}; // ^number of converted mux steps
+static uint_fast8_t adc_roi_count = 0; // frames since last full sweep
+static uint32_t adc_sweep = 0; // duration of last mux sweep in us
+static uint8_t adc_mux_step[SENSOR_N]; // mux step during which a sensor is converted
+static float adc_stamp[SENSOR_N]; // acquisition time of each sensor relative to frame timestamp
 
 #if REVISION == 3
 static uint8_t mux_sequence [MUX_LENGTH] = {PA15, PB3, PB4, PB5}; // digital out pins to switch MUX channels
@@ -79,6 +97,11 @@ static uint8_t mux_sequence [MUX_LENGTH] = {PA15, PB3, PB4, PB5}; // digital out
 static uint8_t mux_sequence [MUX_LENGTH] = {PB8, PB9}; // MR and CP pins of 4-bit counter
 #endif
 
+static const adc_smp_rate adc_smp_rates [TUNE_SMPR_N] = {
+	ADC_SMPR_1_5, ADC_SMPR_2_5, ADC_SMPR_4_5, ADC_SMPR_7_5,
+	ADC_SMPR_19_5, ADC_SMPR_61_5, ADC_SMPR_181_5, ADC_SMPR_601_5
+};
+
 static uint8_t mux_order [MUX_MAX] = {0xf, 0x4, 0xb, 0x3, 0xd, 0x6, 0x9, 0x1, 0xe, 0x5, 0xa, 0x2, 0xc, 0x7, 0x8, 0x0};
 static uint8_t order12 [MUX_MAX*ADC_DUAL_LENGTH*2];
 static uint8_t order3 [MUX_MAX*ADC_SING_LENGTH];
@@ -88,9 +111,17 @@ static volatile uint_fast8_t adc12_eos = 0;
 static volatile uint_fast8_t adc3_eos = 0;
 #endif
 static volatile uint_fast8_t adc12_dma_done = 0;
+static volatile uint_fast8_t adc12_dma_half = 0;
 static volatile uint_fast8_t adc12_dma_err = 0;
 static volatile uint_fast8_t adc3_dma_done = 0;
+static volatile uint_fast8_t adc3_dma_half = 0;
 static volatile uint_fast8_t adc3_dma_err = 0;
+static volatile uint_fast8_t adc_pipelined = 0; // DMA spans a single frame, half-complete marks half of the mux sweep
+static uint_fast8_t adc_oversampling = 1; // conversions per channel and mux step
+static uint8_t adc_smpr = 6; // sample time in use, index into adc_smp_rates
+static volatile uint8_t adc_settle = 0; // mux settle delay in us
+static uint_fast8_t adc_roi = 0; // DMA is armed per frame, covering only the mux steps of interest
+static volatile uint16_t adc_roi_mask = 0xffff; // mux steps to convert in frame being acquired
 static volatile uint_fast8_t adc_time_up = 1;
 static volatile uint_fast8_t adc_raw_ptr = 1;
 static volatile uint_fast8_t mux_counter = MUX_MAX;
@@ -113,6 +144,11 @@ Reset_Mode reset_mode;
 
 static OSC_Timetag now;
 
+#define GOVERNOR_GRACE 6 // idle levels (2^6 frames) at full rate before the governor steps down
+static uint16_t adc_rate = 0; // effective scan rate
+static uint16_t adc_smoothing = 0; // IIR coefficient currently in use
+static void _adc_timer_rate(uint16_t rate);
+
 static void __CCM_TEXT__
 adc_timer_irq(void)
 {
@@ -238,6 +274,32 @@ _counter_inc(void)
 #endif
 }
 
+// stamp current mux step (or end of sweep) of the frame being acquired
+static inline __always_inline void
+_mux_stamp(void)
+{
+	adc_mux_tick[!adc_raw_ptr][mux_counter] = ptp_uptime();
+}
+
+// give the mux outputs time to settle before sampling
+static inline __always_inline void
+_mux_settle(void)
+{
+	if(adc_settle)
+		delay_us(adc_settle);
+}
+
+// advance the mux past steps outside the region of interest of the frame being acquired
+static inline __always_inline void
+_mux_skip(void)
+{
+	while( (mux_counter < MUX_MAX) && !(adc_roi_mask & (1U << mux_counter)) )
+	{
+		_counter_inc();
+		mux_counter++;
+	}
+}
+
 static inline __always_inline void
 _irq_adc_block(void)
 {
@@ -245,9 +307,12 @@ _irq_adc_block(void)
 # if(ADC_SING_LENGTH > 0)
 	if(adc12_eos && adc3_eos)
 	{
+		_mux_skip();
 		_counter_inc();
 		if(mux_counter < MUX_MAX)
 		{
+			_mux_settle();
+			_mux_stamp();
 			mux_counter++;
 
 			adc12_eos = 0;
@@ -255,24 +320,36 @@ _irq_adc_block(void)
 			ADC1->regs->CR |= ADC_CR_ADSTART; // start master(ADC1) and slave(ADC2) conversion
 			ADC3->regs->CR |= ADC_CR_ADSTART;
 		}
+		else
+			_mux_stamp(); // end of sweep
 	}
 # else
+	_mux_skip();
 	_counter_inc();
 	if(mux_counter < MUX_MAX)
 	{
+		_mux_settle();
+		_mux_stamp();
 		mux_counter++;
 
 		ADC1->regs->CR |= ADC_CR_ADSTART; // start master(ADC1) and slave(ADC2) conversion
 	}
+	else
+		_mux_stamp(); // end of sweep
 # endif
 #else
+	_mux_skip();
 	_counter_inc();
 	if(mux_counter < MUX_MAX)
 	{
+		_mux_settle();
+		_mux_stamp();
 		mux_counter++;
 
 		ADC3->regs->CR |= ADC_CR_ADSTART;
 	}
+	else
+		_mux_stamp(); // end of sweep
 #endif
 }
 
@@ -298,7 +375,10 @@ adc12_dma_irq(void)
 	if(isr & 0x8)
 		adc12_dma_err = 1;
 
-	adc12_dma_done = 1;
+	if(isr & 0x4) // half transfer
+		adc12_dma_half = 1;
+	if( (!adc_pipelined && !adc_roi) || (isr & 0x2) ) // transfer complete
+		adc12_dma_done = 1;
 }
 #endif
 
@@ -324,15 +404,87 @@ adc3_dma_irq(void)
 	if(isr & 0x8)
 		adc3_dma_err = 1;
 
-	adc3_dma_done = 1;
+	if(isr & 0x4) // half transfer
+		adc3_dma_half = 1;
+	if( (!adc_pipelined && !adc_roi) || (isr & 0x2) ) // transfer complete
+		adc3_dma_done = 1;
+}
+#endif
+
+// choose the mux steps of the next frame: all of them for a periodic full sweep,
+// otherwise the steps converting the current areas of interest and their neighbours
+static uint16_t
+adc_roi_plan(void)
+{
+	uint16_t steps = 0;
+	uint_fast8_t w;
+
+	if(calibrating || tuning || (++adc_roi_count >= config.sensors.roi.interval) )
+	{
+		adc_roi_count = 0;
+		return 0xffff;
+	}
+
+	for(w=0; w<CMC_MASK_N; w++)
+	{
+		uint32_t m = adc_mask.aoi[w];
+
+		while(m)
+		{
+			uint_fast8_t idx = __builtin_clz(m);
+			m &= ~(0x80000000UL >> idx);
+
+			int_fast16_t pos =(w << 5) + idx;
+			int_fast16_t q;
+			for(q=pos-ADC_ROI_MARGIN; q<=pos+ADC_ROI_MARGIN; q++)
+				if( (q >= 0) && (q < SENSOR_N) )
+					steps |= 1U << adc_mux_step[q];
+		}
+	}
+
+	return steps ? steps : 0xffff; // nothing tracked, keep on sweeping
 }
+
+// arm DMA for a frame of the planned mux steps into raw buffer b, only call while ADCs and DMA are idle
+static void
+adc_roi_frame(uint_fast8_t b)
+{
+	uint16_t steps = adc_roi_plan();
+	uint_fast8_t p;
+	uint_fast8_t n = 0;
+
+	for(p=0; p<MUX_MAX; p++)
+		if(steps & (1U << p))
+			adc_roi_list[b][n++] = p;
+	adc_roi_n[b] = n;
+	adc_roi_mask = steps;
+
+#if(ADC_DUAL_LENGTH > 0)
+	dma_disable(DMA1, DMA_CH1);
+	dma_set_mem_addr(DMA1, DMA_CH1, adc12_raw[b]);
+	dma_set_num_transfers(DMA1, DMA_CH1, ADC_DUAL_LENGTH*adc_oversampling*n);
+	dma_enable(DMA1, DMA_CH1);
 #endif
 
+#if(ADC_SING_LENGTH > 0)
+	dma_disable(DMA2, DMA_CH5);
+	dma_set_mem_addr(DMA2, DMA_CH5, adc3_raw[b]);
+	dma_set_num_transfers(DMA2, DMA_CH5, ADC_SING_LENGTH*adc_oversampling*n);
+	dma_enable(DMA2, DMA_CH5);
+#endif
+}
+
 static inline __always_inline void
 adc_dma_run(void)
 {
 	adc12_dma_done = 0;
+	adc12_dma_half = 0;
 	adc3_dma_done = 0;
+	adc3_dma_half = 0;
+	if(adc_pipelined) // the single-frame DMA always fills the first buffer
+		adc_raw_ptr = 1;
+	if(adc_roi)
+		adc_roi_frame(!adc_raw_ptr);
 	mux_counter = 0;
 #if( (ADC_DUAL_LENGTH > 0) && (ADC_SING_LENGTH > 0) )
 	adc12_eos = 1;
@@ -357,6 +509,82 @@ adc_dma_block(void)
 	adc_raw_ptr ^= 1;
 }
 
+static inline __always_inline void
+adc_dma_block_half(void)
+{ 
+#if(ADC_DUAL_LENGTH  > 0)
+#	if(ADC_SING_LENGTH > 0)
+	while( !adc12_dma_half || !adc3_dma_half ) // wait for all 3 ADCs to finish first half of mux sweep
+#	else // ADC_SING_LENGTH == 0
+	while( !adc12_dma_half ) // wait for ADC12 to finish first half of mux sweep
+#	endif
+#else // ADC_DUAL_LENGTH == 0
+	while( !adc3_dma_half ) // wait for ADC3 to finish first half of mux sweep
+#endif
+		;
+}
+
+// set sample time of all ADCs and mux settle delay, only call while ADCs are idle
+static void
+adc_sample_time(uint8_t smpr, uint8_t settle)
+{
+#if(ADC_DUAL_LENGTH > 0)
+	adc_set_sample_rate(ADC1, adc_smp_rates[smpr]);
+	adc_set_sample_rate(ADC2, adc_smp_rates[smpr]);
+#endif
+
+#if(ADC_SING_LENGTH > 0)
+	adc_set_sample_rate(ADC3, adc_smp_rates[smpr]);
+#endif
+
+	adc_smpr = smpr;
+	adc_settle = settle;
+}
+
+// switch DMA between two-frame double buffering and single-frame pipelining,
+// repeat the regular sequences for oversampling and enable per-frame arming for
+// region-of-interest scanning, only call while ADCs and DMA are idle
+static void
+adc_dma_configure(uint_fast8_t pipelined, uint_fast8_t oversampling, uint_fast8_t roi)
+{
+	uint_fast8_t frames = pipelined ? 1 : 2;
+	uint_fast8_t p;
+
+	for(p=0; p<MUX_MAX; p++) // full sweeps until armed otherwise
+	{
+		adc_roi_list[0][p] = p;
+		adc_roi_list[1][p] = p;
+	}
+	adc_roi_n[0] = MUX_MAX;
+	adc_roi_n[1] = MUX_MAX;
+	adc_roi_mask = 0xffff;
+	adc_roi_count = 0;
+
+#if(ADC_DUAL_LENGTH > 0)
+	adc_set_conv_seq(ADC1, adc1_raw_sequence, ADC_DUAL_LENGTH*oversampling);
+	adc_set_conv_seq(ADC2, adc2_raw_sequence, ADC_DUAL_LENGTH*oversampling);
+
+	dma_disable(DMA1, DMA_CH1);
+	dma_set_mem_addr(DMA1, DMA_CH1, adc12_raw);
+	dma_set_num_transfers(DMA1, DMA_CH1, ADC_DUAL_LENGTH*oversampling*MUX_MAX*frames);
+	dma_enable(DMA1, DMA_CH1); // restarts at first buffer
+#endif
+
+#if(ADC_SING_LENGTH > 0)
+	adc_set_conv_seq(ADC3, adc3_raw_sequence, ADC_SING_LENGTH*oversampling);
+
+	dma_disable(DMA2, DMA_CH5);
+	dma_set_mem_addr(DMA2, DMA_CH5, adc3_raw);
+	dma_set_num_transfers(DMA2, DMA_CH5, ADC_SING_LENGTH*oversampling*MUX_MAX*frames);
+	dma_enable(DMA2, DMA_CH5); // restarts at first buffer
+#endif
+
+	adc_raw_ptr = 1; // next frame goes to first buffer
+	adc_pipelined = pipelined;
+	adc_oversampling = oversampling;
+	adc_roi = roi;
+}
+
 static void //__CCM_TEXT__
 config_cb(uint8_t *ip, uint16_t port, uint8_t *buf, uint16_t len)
 {
@@ -410,25 +638,66 @@ mdns_cb(uint8_t *ip, uint16_t port, uint8_t *buf, uint16_t len)
 	mdns_dispatch(buf, len);
 }
 
-// loops are explicitely unrolled which makes it fast but cumbersome to read
-static void __CCM_TEXT__
-adc_fill(uint_fast8_t raw_ptr)
+// average the oversampled conversions of slots [j0, j1) and sort them into sensor order,
+// slot j of a raw buffer holds the n consecutive sequences of mux step adc_roi_list[raw_ptr][j]
+static inline __always_inline void
+adc_scatter(uint_fast8_t raw_ptr, uint_fast8_t j0, uint_fast8_t j1, uint_fast8_t n)
 {
+	const uint8_t *list = adc_roi_list[raw_ptr];
+	const uint_fast8_t shift = __builtin_ctz(n); // n is a power of two
+	uint_fast8_t j;
 	uint_fast8_t i;
+	uint_fast8_t r;
+
+#if(ADC_DUAL_LENGTH > 0)
+	for(j=j0; j<j1; j++)
+	{
+		const uint_fast8_t p = list[j];
+		const int16_t *step = &adc12_raw[raw_ptr][j*n*ADC_DUAL_LENGTH*2];
+		for(i=0; i<ADC_DUAL_LENGTH*2; i++)
+		{
+			int_fast16_t sum = n/2; // round to nearest
+			for(r=0; r<n; r++)
+				sum += step[r*ADC_DUAL_LENGTH*2 + i];
+			adc_rela[order12[p*ADC_DUAL_LENGTH*2 + i]] = sum >> shift;
+		}
+	}
+#endif
+
+#if(ADC_SING_LENGTH > 0)
+	for(j=j0; j<j1; j++)
+	{
+		const uint_fast8_t p = list[j];
+		const int16_t *step = &adc3_raw[raw_ptr][j*n*ADC_SING_LENGTH];
+		for(i=0; i<ADC_SING_LENGTH; i++)
+		{
+			int_fast16_t sum = n/2; // round to nearest
+			for(r=0; r<n; r++)
+				sum += step[r*ADC_SING_LENGTH + i];
+			adc_rela[order3[p*ADC_SING_LENGTH + i]] = sum >> shift;
+		}
+	}
+#endif
+}
+
+// sort raw samples of slots [p0, p1) into sensor order, slots equal mux steps for plain full sweeps
+static inline __always_inline void
+adc_reorder(uint_fast8_t raw_ptr, uint_fast8_t p0, uint_fast8_t p1)
+{
+	uint_fast16_t i;
 	uint_fast8_t pos;
-	uint32_t *rela_vec32 =(uint32_t *)adc_rela;
-	uint32_t *sum_vec32 =(uint32_t *)adc_sum;
-	uint32_t *qui_vec32 =(uint32_t *)range.qui;
-	uint32_t *swap_vec32 =(uint32_t *)adc_swap;
 
-	uint32_t zero = 0UL;
-	uint_fast8_t dump_enabled = config.dump.enabled; // local copy
-	uint_fast8_t movingaverage_enabled = config.sensors.movingaverage_bitshift > 0; // local copy
-	uint_fast8_t bitshift = config.sensors.movingaverage_bitshift; // local copy
+	if( (adc_oversampling > 1) || (adc_roi_n[raw_ptr] < MUX_MAX) )
+	{
+		if( (p0 == 0) && (adc_roi_n[raw_ptr] < MUX_MAX) ) // sensors outside the regions of interest read as quiescent
+			memcpy(adc_rela, range.qui, sizeof(adc_rela));
+		adc_scatter(raw_ptr, p0, p1, adc_oversampling);
+		return;
+	}
 
 #if(ADC_DUAL_LENGTH > 0)
 	int16_t *raw12 = adc12_raw[raw_ptr];
-	for(i=0; i<MUX_MAX*ADC_DUAL_LENGTH*2; i++)
+	for(i=p0*ADC_DUAL_LENGTH*2; i<p1*ADC_DUAL_LENGTH*2; i++)
 	{
 		pos = order12[i];
 		adc_rela[pos] = raw12[i];
@@ -437,129 +706,309 @@ adc_fill(uint_fast8_t raw_ptr)
 
 #if(ADC_SING_LENGTH > 0)
 	int16_t *raw3 = adc3_raw[raw_ptr];
-	for(i=0; i<MUX_MAX*ADC_SING_LENGTH; i++)
+	for(i=p0*ADC_SING_LENGTH; i<p1*ADC_SING_LENGTH; i++)
 	{
 		pos = order3[i];
 		adc_rela[pos] = raw3[i];
 	}
 #endif
+}
+
+// one pass over all sensor pairs, specialized by the compiler for each combination of the constant flags
+static inline __always_inline void
+adc_fill_pass(const uint_fast8_t smoothing, const uint_fast8_t dump)
+{
+	uint_fast8_t i;
+	uint32_t *rela_vec32 =(uint32_t *)adc_rela;
+	uint32_t *last_vec32 =(uint32_t *)adc_last;
+	uint32_t *alpha_vec32 =(uint32_t *)adc_alpha;
+	uint32_t *qui_vec32 =(uint32_t *)range.qui;
+	uint32_t *swap_vec32 =(uint32_t *)adc_swap;
+	uint16_t *swap_vec16 =(uint16_t *)adc_swap;
+	uint32_t *dump_vec32 =(uint32_t *)adc_dump_last;
+	uint32_t *thresh_vec32 =(uint32_t *)range.thresh;
+
+	for(i=0; i<SENSOR_N/2; i++)
+	{
+		uint32_t rela32;
+		rela32 = __ssub16(rela_vec32[i], qui_vec32[i]); // rela -= qui
+
+		if(smoothing) // first-order IIR: iir += alpha * (rela - last)
+		{
+			uint32_t diff32;
+			int32_t iir0, iir1;
+			diff32 = __ssub16(rela32, last_vec32[i]); // diff = rela - last
+			iir0 = __smlabb(alpha_vec32[i], diff32, adc_iir[2*i]); // iir += alpha * diff, lower sensor
+			iir1 = __smlatt(alpha_vec32[i], diff32, adc_iir[2*i+1]); // iir += alpha * diff, upper sensor
+			adc_iir[2*i] = iir0;
+			adc_iir[2*i+1] = iir1;
+			rela32 = __pkhbt(iir0 >> 15, iir1, 1); // rela = iir / 2^15
+			last_vec32[i] = rela32;
+		}
+
+		rela_vec32[i] = rela32;
+		cmc_mask_pair(&adc_mask, i, rela32, thresh_vec32[i]); // fused threshold detection
+		if(dump == DUMP_FRAME_RAW)
+			swap_vec32[i] = __rev16(rela32); // SIMD hton
+		else if(dump == DUMP_FRAME_INT8)
+		{
+			int32_t lo = (int32_t)(rela32 << 16) >> (16 + DUMP_INT8_SHIFT);
+			int32_t hi = (int32_t)rela32 >> DUMP_INT8_SHIFT;
+			uint32_t q32 = __ssat16(__pkhbt(lo, hi, 0), 8); // scale and saturate to int8
+			swap_vec16[i] = (q32 & 0xff) | ((q32 >> 8) & 0xff00); // pack bytes
+		}
+		else if(dump == DUMP_FRAME_DELTA)
+		{
+			uint32_t diff32 = __ssub16(rela32, dump_vec32[i]); // diff = rela - dump_last
+			uint32_t sign32 = __ssub16(0, (diff32 >> 15) & 0x00010001); // 0xffff for negative diff
+			swap_vec32[i] = ((diff32 << 1) & 0xfffefffe) ^ sign32; // SIMD zig-zag
+			dump_vec32[i] = rela32;
+		}
+	}
+}
+
+static void __CCM_TEXT__
+adc_fill(uint_fast8_t raw_ptr, uint_fast8_t p0, uint_fast8_t dump)
+{
+	uint_fast8_t smoothing_enabled = adc_smoothing > 0; // local copy
+
+	adc_reorder(raw_ptr, p0, adc_roi_n[raw_ptr]); // slots before p0 have already been sorted
+
+	cmc_mask_clear(&adc_mask);
+
+	if(dump == DUMP_FRAME_KEY) // keyframes are deltas to zero
+	{
+		memset(adc_dump_last, 0, sizeof(adc_dump_last));
+		dump = DUMP_FRAME_DELTA;
+	}
 
-	if(movingaverage_enabled)
+	if(smoothing_enabled)
 	{
-		switch(bitshift)
+		switch(dump)
 		{
-			case 1: // 2^1 = 2 samples moving average
-				if(dump_enabled)
-					for(i=0; i<SENSOR_N/2; i++)
-					{
-						uint32_t rela32;
-						rela32 = __ssub16(rela_vec32[i], qui_vec32[i]); // rela -= qui
-
-						sum_vec32[i] = __sadd16(sum_vec32[i], rela32); // sum += rela
-						rela32 = __shadd16(sum_vec32[i], zero); // rela = sum / 2
-						sum_vec32[i] = __ssub16(sum_vec32[i], rela32); // sum -= rela
-
-						rela_vec32[i] = rela32;
-						swap_vec32[i] = __rev16(rela32); // SIMD hton
-					}
-				else // !dump_enabled
-					for(i=0; i<SENSOR_N/2; i++)
-					{
-						uint32_t rela32;
-						rela32 = __ssub16(rela_vec32[i], qui_vec32[i]); // rela -= qui
-
-						sum_vec32[i] = __sadd16(sum_vec32[i], rela32); // sum += rela
-						rela32 = __shadd16(sum_vec32[i], zero); // rela = sum / 2
-						sum_vec32[i] = __ssub16(sum_vec32[i], rela32); // sum -= rela
-
-						rela_vec32[i] = rela32;
-					}
+			case DUMP_FRAME_RAW:
+				adc_fill_pass(1, DUMP_FRAME_RAW);
 				break;
-			case 2: // 2^2 = 4 samples moving average
-				if(dump_enabled)
-					for(i=0; i<SENSOR_N/2; i++)
-					{
-						uint32_t rela32;
-						rela32 = __ssub16(rela_vec32[i], qui_vec32[i]); // rela -= qui
-
-						sum_vec32[i] = __sadd16(sum_vec32[i], rela32); // sum += rela
-						rela32 = __shadd16(sum_vec32[i], zero); // rela = sum / 2
-						rela32 = __shadd16(rela32, zero); // rela = rela / 2
-						sum_vec32[i] = __ssub16(sum_vec32[i], rela32); // sum -= rela
-
-						rela_vec32[i] = rela32;
-						swap_vec32[i] = __rev16(rela32); // SIMD hton
-					}
-				else // !dump_enabled
-					for(i=0; i<SENSOR_N/2; i++)
-					{
-						uint32_t rela32;
-						rela32 = __ssub16(rela_vec32[i], qui_vec32[i]); // rela -= qui
-
-						sum_vec32[i] = __sadd16(sum_vec32[i], rela32); // sum += rela
-						rela32 = __shadd16(sum_vec32[i], zero); // rela = sum / 2
-						rela32 = __shadd16(rela32, zero); // rela = rela / 2
-						sum_vec32[i] = __ssub16(sum_vec32[i], rela32); // sum -= rela
-
-						rela_vec32[i] = rela32;
-					}
+			case DUMP_FRAME_INT8:
+				adc_fill_pass(1, DUMP_FRAME_INT8);
 				break;
-			case 3: // 2^3 = 8 samples moving average
-				if(dump_enabled)
-					for(i=0; i<SENSOR_N/2; i++)
-					{
-						uint32_t rela32;
-						rela32 = __ssub16(rela_vec32[i], qui_vec32[i]); // rela -= qui
-
-						sum_vec32[i] = __sadd16(sum_vec32[i], rela32); // sum += rela
-						rela32 = __shadd16(sum_vec32[i], zero); // rela = sum / 2
-						rela32 = __shadd16(rela32, zero); // rela = rela / 2
-						rela32 = __shadd16(rela32, zero); // rela = rela / 2
-						sum_vec32[i] = __ssub16(sum_vec32[i], rela32); // sum -= rela
-
-						rela_vec32[i] = rela32;
-						swap_vec32[i] = __rev16(rela32); // SIMD hton
-					}
-				else // !dump_enabled
-					for(i=0; i<SENSOR_N/2; i++)
-					{
-						uint32_t rela32;
-						rela32 = __ssub16(rela_vec32[i], qui_vec32[i]); // rela -= qui
-
-						sum_vec32[i] = __sadd16(sum_vec32[i], rela32); // sum += rela
-						rela32 = __shadd16(sum_vec32[i], zero); // rela = sum / 2
-						rela32 = __shadd16(rela32, zero); // rela = rela / 2
-						rela32 = __shadd16(rela32, zero); // rela = rela / 2
-						sum_vec32[i] = __ssub16(sum_vec32[i], rela32); // sum -= rela
-
-						rela_vec32[i] = rela32;
-					}
+			case DUMP_FRAME_DELTA:
+				adc_fill_pass(1, DUMP_FRAME_DELTA);
+				break;
+			default: // DUMP_FRAME_SKIP
+				adc_fill_pass(1, DUMP_FRAME_SKIP);
 				break;
 		}
 	}
-	else // !movingaverage_enabled
+	else // !smoothing_enabled
 	{
-		if(dump_enabled)
-			for(i=0; i<SENSOR_N/2; i++)
-			{
-				rela_vec32[i] = __ssub16(rela_vec32[i], qui_vec32[i]); // SIMD sub
-				swap_vec32[i] = __rev16(rela_vec32[i]); // SIMD hton
-			}
-		else // !dump_enabled
-			for(i=0; i<SENSOR_N/2; i++)
-			{
-				rela_vec32[i] = __ssub16(rela_vec32[i], qui_vec32[i]); // SIMD sub
-			}
+		switch(dump)
+		{
+			case DUMP_FRAME_RAW:
+				adc_fill_pass(0, DUMP_FRAME_RAW);
+				break;
+			case DUMP_FRAME_INT8:
+				adc_fill_pass(0, DUMP_FRAME_INT8);
+				break;
+			case DUMP_FRAME_DELTA:
+				adc_fill_pass(0, DUMP_FRAME_DELTA);
+				break;
+			default: // DUMP_FRAME_SKIP
+				adc_fill_pass(0, DUMP_FRAME_SKIP);
+				break;
+		}
+	}
+}
+
+// derive per-sensor acquisition times relative to the frame timestamp from the mux step stamps
+// steps skipped outside the regions of interest have not been stamped in this buffer, they get the frame timestamp
+static inline __always_inline void
+adc_stamp_update(uint_fast8_t raw_ptr, int64_t tick)
+{
+	float step [MUX_MAX];
+	const uint8_t *list = adc_roi_list[raw_ptr];
+	uint_fast8_t p;
+	uint_fast8_t pos;
+
+	for(p=0; p<MUX_MAX; p++)
+		step[p] = 0.f;
+
+	for(p=0; p<adc_roi_n[raw_ptr]; p++)
+		step[list[p]] = (adc_mux_tick[raw_ptr][list[p]] - tick) * 1e-6f;
+
+	for(pos=0; pos<SENSOR_N; pos++)
+		adc_stamp[pos] = step[adc_mux_step[pos]];
+}
+
+// spread the configured IIR coefficient over the per-sensor coefficients
+static void
+adc_smoothing_update(uint16_t smoothing)
+{
+	uint_fast8_t pos;
+
+	for(pos=0; pos<SENSOR_N; pos++)
+	{
+		adc_alpha[pos] = smoothing;
+		// restart the filter from the last output, state of a former coefficient would show up as ghost blobs
+		adc_last[pos] = adc_rela[pos];
+		adc_iir[pos] = (int32_t)adc_rela[pos] << 15;
+	}
+
+	adc_smoothing = smoothing;
+}
+
+#if OUTPUT_FANOUT_MAX > 0
+static osc_data_t *fanout_bndl [OUTPUT_FANOUT_MAX];
+static uint16_t fanout_len [OUTPUT_FANOUT_MAX];
+
+// prepare fanout buffers of destinations with engines routed to them
+static void
+output_fanout_start(void)
+{
+	uint_fast8_t d;
+
+	for(d=0; d<OUTPUT_FANOUT_MAX; d++)
+	{
+		CMC_Output *out = &cmc_fanout[d];
+
+		out->ptr = BUF_F_OFFSET(d);
+		out->end = BUF_F_MAX(d);
+		fanout_bndl[d] = NULL;
+		if(cmc_dest_engines[d+1] > 1)
+			out->ptr = osc_start_bundle(out->ptr, out->end, OSC_IMMEDIATE, &fanout_bndl[d]); // node bundle
+	}
+}
+
+// finalize fanout buffers, empty node bundles are not sent
+static void
+output_fanout_end(void)
+{
+	uint_fast8_t d;
+
+	for(d=0; d<OUTPUT_FANOUT_MAX; d++)
+	{
+		CMC_Output *out = &cmc_fanout[d];
+
+		if(fanout_bndl[d])
+			out->ptr = osc_end_bundle(out->ptr, out->end, fanout_bndl[d]); // node bundle
+		fanout_len[d] = osc_len(out->ptr, BUF_F_OFFSET(d));
+	}
+}
+
+// blocking send of fanout buffers via the output socket, restores its remote afterwards
+static void
+output_fanout_send(void)
+{
+	Socket_Config *socket = &config.output.osc.socket;
+	uint_fast8_t sent = 0;
+	uint_fast8_t d;
+
+	for(d=0; d<OUTPUT_FANOUT_MAX; d++)
+	{
+		Socket_Config *fanout = &config.output.fanout[d];
+
+		if(!fanout_len[d])
+			continue;
+
+		udp_set_remote(socket->sock, fanout->ip, fanout->port[DST_PORT]);
+		udp_send(socket->sock, BUF_F_BASE(d), fanout_len[d]);
+		sent = 1;
+	}
+
+	if(sent)
+		udp_set_remote(socket->sock, socket->ip, socket->port[DST_PORT]);
+}
+#endif // OUTPUT_FANOUT_MAX
+
+// scan at full rate while active, step down one octave per idle level beyond the grace period
+static void
+adc_governor(void)
+{
+	uint_fast8_t level = !calibrating && !tuning && cmc_engines_active ? cmc_idle_level() : 0;
+	uint16_t rate = config.sensors.rate;
+	uint16_t min = config.sensors.governor.min < rate ? config.sensors.governor.min : rate;
+
+	if(level > GOVERNOR_GRACE)
+		rate >>= level - GOVERNOR_GRACE;
+	if(rate < min)
+		rate = min;
+
+	if(rate != adc_rate)
+		_adc_timer_rate(rate);
+}
+
+static uint_fast8_t cmc_stat = 0;
+static uint_fast8_t cmc_job = 0;
+static uint_fast16_t cmc_len = 0;
+static osc_data_t *output_base; // output packet after opening preamble and node bundle
+static osc_data_t *output_preamble;
+static osc_data_t *output_bndl;
+
+// open preamble and node bundle of an output packet
+static osc_data_t *
+output_start(osc_data_t *buf, osc_data_t *end)
+{
+	osc_data_t *buf_ptr = buf;
+
+	output_preamble = NULL;
+	output_bndl = NULL;
+	if(config.output.osc.mode == OSC_MODE_TCP)
+		buf_ptr = osc_start_bundle_item(buf_ptr, end, &output_preamble);
+	if(cmc_dest_engines[0] + config.dump.enabled > 1)
+		buf_ptr = osc_start_bundle(buf_ptr, end, OSC_IMMEDIATE, &output_bndl); // node bundle
+	output_base = buf_ptr;
+
+	return buf_ptr;
+}
+
+// close node bundle and preamble of an output packet, returns its encoded length
+static uint_fast16_t
+output_end(osc_data_t *buf_ptr, osc_data_t *buf, osc_data_t *end)
+{
+	uint_fast16_t len;
+
+	if(cmc_dest_engines[0] + config.dump.enabled > 1)
+		buf_ptr = osc_end_bundle(buf_ptr, end, output_bndl); // node bundle
+	if(config.output.osc.mode == OSC_MODE_TCP)
+		buf_ptr = osc_end_bundle_item(buf_ptr, end, output_preamble);
+
+	len = osc_len(buf_ptr, buf);
+	if( (len > 0) && (config.output.osc.mode == OSC_MODE_SLIP) )
+		len = slip_encode(buf, len);
+
+	return len;
+}
+
+// send output packet built so far and continue the frame in the other output buffer
+static osc_data_t *
+output_flush(osc_data_t *buf_ptr, osc_data_t **end)
+{
+	if(buf_ptr == output_base) // nothing to send yet
+		return buf_ptr;
+
+	uint_fast16_t len = output_end(buf_ptr, BUF_O_OFFSET(buf_o_ptr), *end);
+	if(len > 0)
+	{
+		if(config.output.parallel)
+		{
+			if(cmc_job && cmc_stat) // block for end of sending of last output
+				osc_send_block(&config.output.osc);
+			cmc_stat = osc_send_nonblocking(&config.output.osc, BUF_O_BASE(buf_o_ptr), len);
+			cmc_job = 1;
+			buf_o_ptr ^= 1;
+		}
+		else
+			osc_send(&config.output.osc, BUF_O_BASE(buf_o_ptr), len);
 	}
+
+	*end = BUF_O_MAX(buf_o_ptr);
+	return output_start(BUF_O_OFFSET(buf_o_ptr), *end);
 }
 
 void loop(void);
 void
 loop(void)
 {
-	uint_fast8_t cmc_stat;
-	uint_fast8_t cmc_job = 0;
-	uint_fast16_t cmc_len = 0;
 	uint_fast16_t len = 0;
 
 	uint_fast8_t first = 1;
@@ -627,8 +1076,23 @@ loop(void)
 			continue;
 		}
 
+		if(adc_pipelined) // process the frame being acquired within this cycle
+		{
+			adc_dma_block_half();
+			adc_reorder(!adc_raw_ptr, 0, adc_roi_n[!adc_raw_ptr]/2); // while second half of mux sweep is converting
+			adc_dma_block();
+		}
+
 		if(calibrating)
-			range_calibrate(adc12_raw[adc_raw_ptr], adc3_raw[adc_raw_ptr], order12, order3, adc_sum, adc_rela);
+		{
+			adc_reorder(adc_raw_ptr, 0, adc_roi_n[adc_raw_ptr]);
+			range_calibrate(adc_rela);
+		}
+		else if(tuning)
+		{
+			adc_reorder(adc_raw_ptr, 0, adc_roi_n[adc_raw_ptr]);
+			tune_process(adc_rela);
+		}
 
 		if(config.output.osc.socket.enabled && (wiz_socket_state[SOCK_OUTPUT] == WIZ_SOCKET_STATE_OPEN) )
 		{
@@ -646,52 +1110,47 @@ loop(void)
 #ifdef BENCHMARK
 			stop_watch_start(&sw_adc_fill);
 #endif
-			adc_fill(adc_raw_ptr);
+			uint_fast8_t dump = config.dump.enabled ? dump_frame() : DUMP_FRAME_SKIP; // decimation and encoding of this frame
+			adc_fill(adc_raw_ptr, adc_pipelined ? adc_roi_n[adc_raw_ptr]/2 : 0, dump);
+			if(config.sensors.health.enabled && !calibrating && !tuning && (adc_roi_n[adc_raw_ptr] == MUX_MAX) ) // ROI frames hold stale values
+				sensors_health_update(adc_rela, &adc_mask);
 
+			int64_t tick = ptp_uptime();
+			adc_sweep = adc_mux_tick[adc_raw_ptr][MUX_MAX] - adc_mux_tick[adc_raw_ptr][adc_roi_list[adc_raw_ptr][0]];
 			if(config.sntp.socket.enabled)
-				sntp_timestamp_refresh(ptp_uptime(), &now, &offset);
+				sntp_timestamp_refresh(tick, &now, &offset);
 			else if(config.ptp.event.enabled)
-				ptp_timestamp_refresh(ptp_uptime(), &now, &offset);
+				ptp_timestamp_refresh(tick, &now, &offset);
 			else // neither sNTP nor PTP active
-				sntp_timestamp_refresh(ptp_uptime(), &now, &offset);
+				sntp_timestamp_refresh(tick, &now, &offset);
 
 			// initiate OSC bundle
-			osc_data_t *buf = BUF_O_OFFSET(buf_o_ptr);
 			osc_data_t *end = BUF_O_MAX(buf_o_ptr);
-			osc_data_t *buf_ptr = buf;
-			osc_data_t *preamble = NULL;
-			osc_data_t *bndl = NULL;
-			if(config.output.osc.mode == OSC_MODE_TCP)
-				buf_ptr = osc_start_bundle_item(buf_ptr, end, &preamble);
-			if(cmc_engines_active + config.dump.enabled > 1)
-				buf_ptr = osc_start_bundle(buf_ptr, end, OSC_IMMEDIATE, &bndl); // node bundle
-
-			if(config.dump.enabled) // dump output is functional even when calibrating
-				buf_ptr = dump_update(buf_ptr, end, now, offset, sizeof(adc_swap), adc_swap);
+			osc_data_t *buf_ptr = output_start(BUF_O_OFFSET(buf_o_ptr), end);
+
+			if(dump) // dump output is functional even when calibrating
+				buf_ptr = dump_update(buf_ptr, end, now, offset, dump, adc_swap);
 		
-			if(!calibrating && cmc_engines_active) // output engines are disfunctional when calibrating
+#if OUTPUT_FANOUT_MAX > 0
+			output_fanout_start();
+#endif
+
+			if(!calibrating && !tuning && cmc_engines_active) // output engines are disfunctional when calibrating or tuning
 			{
 #ifdef BENCHMARK
 				stop_watch_start(&sw_blob_process);
 #endif
-				buf_ptr = cmc_process(now, offset, adc_rela, buf_ptr, end); // touch recognition of current cycle
+				adc_stamp_update(adc_raw_ptr, tick);
+				buf_ptr = cmc_process(now, offset, adc_rela, &adc_mask, adc_stamp, buf_ptr, end); // touch recognition of current cycle
 			}
-			
-			if(cmc_engines_active + config.dump.enabled > 1)
-				buf_ptr = osc_end_bundle(buf_ptr, end, bndl); // node bundle
-			if(config.output.osc.mode == OSC_MODE_TCP)
-				buf_ptr = osc_end_bundle_item(buf_ptr, end, preamble);
-
-			cmc_len = osc_len(buf_ptr, buf);
-			if(cmc_len > 0) // is there anything after OSC bundle header?
-			{
-				job = 1;
 
-				if(config.output.osc.mode == OSC_MODE_SLIP)
-					cmc_len = slip_encode(buf, cmc_len);
-			}
-			else // cmc_len <= 16
-				job = 0;
+#if OUTPUT_FANOUT_MAX > 0
+			output_fanout_end();
+#endif
+			
+			// cmc_process may have flushed parts of the frame via output_flush
+			cmc_len = output_end(buf_ptr, BUF_O_OFFSET(buf_o_ptr), BUF_O_MAX(buf_o_ptr));
+			job = cmc_len > 0; // is there anything after OSC bundle header?
 
 #ifdef BENCHMARK
 			stop_watch_start(&sw_output_block);
@@ -711,6 +1170,10 @@ loop(void)
 				cmc_job = 0;
 			}
 
+#if OUTPUT_FANOUT_MAX > 0
+			output_fanout_send(); // after primary output is through
+#endif
+
 #ifdef BENCHMARK
 			stop_watch_stop(&sw_output_send);
 			stop_watch_stop(&sw_adc_fill);
@@ -883,20 +1346,42 @@ loop(void)
 		}
 		*/
 
-		adc_dma_block();
+		if(!adc_pipelined) // wait for acquisition of next cycle's frame
+			adc_dma_block();
+
+		if( (config.sensors.pipelined != adc_pipelined) || (config.sensors.oversampling != adc_oversampling)
+			|| (config.sensors.roi.enabled != adc_roi) ) // DMA is idle here
+		{
+			adc_dma_configure(config.sensors.pipelined, config.sensors.oversampling, config.sensors.roi.enabled);
+			first = 1; // the pending frame may have been acquired with the old layout
+		}
+
+		if( (tune_smpr != adc_smpr) || (tune_settle != adc_settle) ) // ADCs are idle here
+		{
+			adc_sample_time(tune_smpr, tune_settle);
+			first = 1; // the pending frame has been acquired with the old setting
+		}
+
+		if(config.sensors.smoothing != adc_smoothing)
+			adc_smoothing_update(config.sensors.smoothing);
 
 		if(config.sensors.rate)
+		{
 			while(!adc_time_up)
 				;
+
+			if(config.sensors.governor.enabled) // adc_timer is paused here
+				adc_governor();
+		}
 	} // endless loop
 }
 
-void
-adc_timer_reconfigure(void)
+static void
+_adc_timer_rate(uint16_t rate)
 {
 	// this scheme is good for rates in the range of 20-2000+
 	uint16_t prescaler = 50-1;
-	uint16_t reload = 72e6 / (config.sensors.rate * 50);
+	uint16_t reload = 72e6 / (rate * 50);
 	uint16_t compare = reload;
 
 	timer_set_prescaler(adc_timer, prescaler);
@@ -907,6 +1392,26 @@ adc_timer_reconfigure(void)
 	timer_generate_update(adc_timer);
 
 	nvic_irq_set_priority(NVIC_ADC_TIMER, ADC_TIMER_PRIORITY);
+
+	adc_rate = rate;
+}
+
+void
+adc_timer_reconfigure(void)
+{
+	_adc_timer_rate(config.sensors.rate);
+}
+
+uint16_t
+adc_timer_rate(void)
+{
+	return adc_rate;
+}
+
+uint32_t
+adc_sweep_time(void)
+{
+	return adc_sweep;
 }
 
 void 
@@ -1094,8 +1599,9 @@ setup(void)
 	if(!config.comm.custom_mac)
 		eeprom_bulk_read(eeprom_24AA025E48, 0xfa, config.comm.mac, 6);
 
-	// load calibrated sensor ranges from eeprom
+	// load calibrated sensor ranges and ADC tuning from eeprom
 	range_load(0);
+	tune_load();
 
 	// init DMA, which is used for SPI and ADC
 	dma_init(DMA1);
@@ -1163,6 +1669,7 @@ setup(void)
 	timer_init(adc_timer);
 	timer_pause(adc_timer);
 	adc_timer_reconfigure();
+	adc_smoothing_update(config.sensors.smoothing);
 
 	timer_init(sync_timer);
 
@@ -1201,15 +1708,14 @@ setup(void)
 #if(ADC_DUAL_LENGTH > 0)
 	adc_set_exttrig(ADC1, ADC_EXTTRIG_MODE_SOFTWARE);
 	adc_set_exttrig(ADC2, ADC_EXTTRIG_MODE_SOFTWARE);
-	adc_set_sample_rate(ADC1, ADC_SMPR_181_5);
-	adc_set_sample_rate(ADC2, ADC_SMPR_181_5);
 #endif
 
 #if(ADC_SING_LENGTH > 0)
 	adc_set_exttrig(ADC3, ADC_EXTTRIG_MODE_SOFTWARE);
-	adc_set_sample_rate(ADC3, ADC_SMPR_181_5);
 #endif
 
+	adc_sample_time(tune_smpr, tune_settle); // as tuned, 181.5 cycles without settle delay by default
+
 #if(ADC_UNUSED_LENGTH > 0)
 	// setup analog input pins
 	for(i=0; i<ADC_UNUSED_LENGTH; i++)
@@ -1224,16 +1730,19 @@ setup(void)
 		pin_set_modef(adc2_sequence[i], GPIO_MODE_ANALOG, GPIO_MODEF_PUPD_NONE);
 	}
 
-	// fill raw sequence array with corresponding ADC channels
-	for(i=0; i<ADC_DUAL_LENGTH; i++)
+	// fill raw sequence array with corresponding ADC channels, repeated for oversampling
+	for(i=0; i<ADC_DUAL_LENGTH*ADC_OVERSAMPLING_MAX; i++)
 	{
-		adc1_raw_sequence[i] = PIN_MAP[adc1_sequence[i]].adc_channel;
-		adc2_raw_sequence[i] = PIN_MAP[adc2_sequence[i]].adc_channel;
+		adc1_raw_sequence[i] = PIN_MAP[adc1_sequence[i % ADC_DUAL_LENGTH]].adc_channel;
+		adc2_raw_sequence[i] = PIN_MAP[adc2_sequence[i % ADC_DUAL_LENGTH]].adc_channel;
 	}
 
 	for(p=0; p<MUX_MAX; p++)
 		for(i=0; i<ADC_DUAL_LENGTH*2; i++)
+		{
 			order12[p*ADC_DUAL_LENGTH*2 + i] = mux_order[p] + adc_order[i]*MUX_MAX;
+			adc_mux_step[order12[p*ADC_DUAL_LENGTH*2 + i]] = p;
+		}
 
 	// set channels in register
 	adc_set_conv_seq(ADC1, adc1_raw_sequence, ADC_DUAL_LENGTH);
@@ -1268,13 +1777,16 @@ setup(void)
 	for(i=0; i<ADC_SING_LENGTH; i++)
 		pin_set_modef(adc3_sequence[i], GPIO_MODE_ANALOG, GPIO_MODEF_PUPD_NONE);
 
-	// fill raw sequence array with corresponding ADC channels
-	for(i=0; i<ADC_SING_LENGTH; i++)
-		adc3_raw_sequence[i] = PIN_MAP[adc3_sequence[i]].adc_channel;
+	// fill raw sequence array with corresponding ADC channels, repeated for oversampling
+	for(i=0; i<ADC_SING_LENGTH*ADC_OVERSAMPLING_MAX; i++)
+		adc3_raw_sequence[i] = PIN_MAP[adc3_sequence[i % ADC_SING_LENGTH]].adc_channel;
 
 	for(p=0; p<MUX_MAX; p++)
 		for(i=0; i<ADC_SING_LENGTH; i++)
+		{
 			order3[p*ADC_SING_LENGTH + i] = mux_order[p] + adc_order[ADC_DUAL_LENGTH*2+i]*MUX_MAX;
+			adc_mux_step[order3[p*ADC_SING_LENGTH + i]] = p;
+		}
 
 	// set channels in register
 	adc_set_conv_seq(ADC3, adc3_raw_sequence, ADC_SING_LENGTH);
@@ -1301,8 +1813,15 @@ setup(void)
 	nvic_irq_set_priority(NVIC_DMA_CH5, ADC_DMA_PRIORITY);
 #endif
 
+	for(p=0; p<MUX_MAX; p++) // full sweeps until region-of-interest scanning is configured
+	{
+		adc_roi_list[0][p] = p;
+		adc_roi_list[1][p] = p;
+	}
+
 	// set up continuous music controller output engines
 	cmc_init();
+	cmc_flush_cb = output_flush;
 
 	pin_write_bit(CHIM_LED_PIN, 1);
 	DEBUG("si", "config_size", sizeof(Config));
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+/*
+ * accuracy of the distance lookup table
+ *
+ * compares curve_lookup() against the previous 2048-entry modff-based
+ * linear interpolation and against the exact curve, for a set of curve-fit
+ * parameters. Fails when the new table is more than twice as far off the
+ * exact curve as the previous one.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include <chimaera.h>
+#include <oscquery.h>
+#include <calibration.h>
+
+#define SAMPLES 1000000
+
+static float old_curve [0x800 + 1];
+
+static float
+_exact(const float *C, float x)
+{
+	float y = C[0]*cbrtf(x) + C[1]*sqrtf(x) + C[2]*x;
+	return y < 0.f ? 0.f :(y > 1.f ? 1.f : y);
+}
+
+// previous implementation of range_curve_update and LOOKUP
+static void
+_old_update(const float *C)
+{
+	uint32_t i;
+	for(i=0; i<0x800; i++)
+		old_curve[i] = _exact(C, (float)i / (float)0x7ff);
+	old_curve[0x800] = old_curve[0x7ff]; // LOOKUP(1.f) reads one past the end with f == 0
+}
+
+static float
+_old_lookup(float y)
+{
+	float f, i;
+	uint16_t ii;
+
+	y *= 0x7ff;
+	f = modff(y, &i);
+	ii = i;
+	return old_curve[ii] + f*(old_curve[ii+1] - old_curve[ii]);
+}
+
+int
+main(void)
+{
+	static const float params [][3] = {
+		{0.f, 1.f, 0.f}, // factory default: sqrt
+		{1.f, 0.f, 0.f}, // cbrt
+		{0.f, 0.f, 1.f}, // linear
+		{0.3f, 0.5f, 0.2f},
+		{-0.4f, 1.6f, -0.2f},
+		{0.8f, 0.6f, -0.4f}
+	};
+	int ret = 0;
+	uint_fast8_t p;
+
+	printf("# %-22s %12s %12s %12s %12s %12s\n", "C0 C1 C2", "max|new-old|", "max|old-ex|", "max|new-ex|", "rms|old-ex|", "rms|new-ex|");
+
+	for(p=0; p<sizeof(params)/sizeof(params[0]); p++)
+	{
+		const float *C = params[p];
+
+		range_reset();
+		range.C[0] = C[0];
+		range.C[1] = C[1];
+		range.C[2] = C[2];
+		range_curve_update();
+		_old_update(C);
+
+		double max_diff = 0.0;
+		double max_old = 0.0;
+		double max_new = 0.0;
+		double sum_old = 0.0;
+		double sum_new = 0.0;
+		uint32_t i;
+		for(i=0; i<=SAMPLES; i++)
+		{
+			float x = (float)i / SAMPLES;
+			double ex = _exact(C, x);
+			double o = _old_lookup(x);
+			double n = curve_lookup(x);
+
+			max_diff = fmax(max_diff, fabs(n - o));
+			max_old = fmax(max_old, fabs(o - ex));
+			max_new = fmax(max_new, fabs(n - ex));
+			sum_old += (o - ex)*(o - ex);
+			sum_new += (n - ex)*(n - ex);
+		}
+
+		printf("  %6.2f %6.2f %6.2f     %12.3e %12.3e %12.3e %12.3e %12.3e\n", C[0], C[1], C[2],
+			max_diff, max_old, max_new, sqrt(sum_old / (SAMPLES + 1)), sqrt(sum_new / (SAMPLES + 1)));
+
+		if(max_new > 2.0*max_old + 1e-6)
+			ret = -1;
+	}
+
+	printf(ret ? "FAIL\n" : "PASS\n");
+
+	return ret;
+}
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+/*
+ * host frame-replay benchmark
+ *
+ * feeds either recorded raw frames or synthetic ones through cmc_process
+ * with each output engine enabled on its own and reports processing time,
+ * number of blobs and number of emitted bytes per frame.
+ *
+ * with -S, synthetic frames are generated for every blob count up to
+ * BLOB_MAX to show how the per-frame cost scales with the number of blobs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chimaera.h>
+#include <config.h>
+#include <wiz.h>
+#include <calibration.h>
+#include <cmc.h>
+
+#include <sensors.h>
+
+#include "capture.h"
+#include "select.h"
+
+static int16_t *frames = NULL;
+static uint32_t n_frames = 0;
+
+static CMC_Engine_Frame_Cb frame_cb_orig = NULL;
+static uint64_t blobs_total = 0;
+
+// interposed frame callback of the engine under test to count blobs
+static osc_data_t *
+_frame_cb_count(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
+{
+	blobs_total += fev->nblob_new;
+
+	return frame_cb_orig ? frame_cb_orig(buf, end, fev) : buf;
+}
+
+static inline uint64_t
+_nsec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+// load frames and calibration snapshot from a capture file
+static int
+_frames_load(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	if(!f)
+	{
+		perror(path);
+		return -1;
+	}
+
+	Capture_Header hdr;
+	if(capture_read_header(f, &hdr))
+	{
+		fprintf(stderr, "%s: no capture file for SENSOR_N=%i\n", path, SENSOR_N);
+		fclose(f);
+		return -1;
+	}
+
+	range = hdr.range;
+	range_curve_update();
+	config.sensors.rate = hdr.rate;
+
+	Capture_Frame frm;
+	uint32_t max = 0;
+	while(!capture_read_frame(f, &frm))
+	{
+		if(n_frames == max)
+		{
+			max = max ? max*2 : 0x1000;
+			frames = realloc(frames, max*SENSOR_N*sizeof(int16_t));
+			if(!frames)
+			{
+				fclose(f);
+				return -1;
+			}
+		}
+		memcpy(&frames[n_frames++*SENSOR_N], frm.rela, SENSOR_N*sizeof(int16_t));
+	}
+
+	fclose(f);
+
+	return 0;
+}
+
+// synthesize frames with N gaussian bumps of alternating polarity drifting along the sensor array
+static int
+_frames_synth(uint32_t n, uint_fast8_t bumps, unsigned seed)
+{
+	n_frames = n;
+	frames = calloc(n_frames, SENSOR_N*sizeof(int16_t));
+	if(!frames)
+		return -1;
+
+	srand(seed);
+
+	float x [BLOB_MAX];
+	float v [BLOB_MAX];
+	float z [BLOB_MAX];
+	uint_fast8_t b;
+	for(b=0; b<bumps; b++)
+	{
+		x[b] = (b + 0.5f) * SENSOR_N / bumps;
+		v[b] = ((float)rand() / RAND_MAX - 0.5f) * 0.05f;
+		z[b] = 0.5f + 0.5f * rand() / RAND_MAX;
+	}
+
+	uint32_t i;
+	for(i=0; i<n_frames; i++)
+	{
+		int16_t *rela = &frames[i*SENSOR_N];
+		uint_fast8_t j;
+
+		for(b=0; b<bumps; b++)
+		{
+			x[b] += v[b];
+			if( (x[b] < 1.f) || (x[b] > SENSOR_N - 2) )
+				v[b] *= -1.f;
+
+			float amp = z[b] * ADC_HALF_BITDEPTH;
+			int16_t pol = b % 2 ? -1 : 1;
+			for(j=0; j<SENSOR_N; j++)
+			{
+				float dx = j - x[b];
+				float val = amp * expf(-dx*dx * 0.5f);
+				rela[j] += pol * (int16_t)val;
+			}
+		}
+
+		for(j=0; j<SENSOR_N; j++) // sensor noise
+			rela[j] += rand() % 9 - 4;
+	}
+
+	return 0;
+}
+
+// store frames together with calibration as capture file
+static int
+_frames_save(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+	if(!f || capture_write_header(f, config.sensors.rate, &range))
+	{
+		perror(path);
+		if(f)
+			fclose(f);
+		return -1;
+	}
+
+	Capture_Frame frm;
+	memset(&frm, 0x0, sizeof(frm));
+
+	uint64_t dt = (1ULL << 32) / config.sensors.rate;
+	uint64_t now = 1ULL << 32;
+	uint64_t offset = (uint64_t)(config.output.offset * 4294967296.0);
+
+	uint32_t i;
+	for(i=0; i<n_frames; i++)
+	{
+		frm.fid = i + 1;
+		frm.now = now;
+		frm.offset = now + offset;
+		memcpy(frm.rela, &frames[i*SENSOR_N], SENSOR_N*sizeof(int16_t));
+
+		if(capture_write_frame(f, &frm))
+		{
+			fclose(f);
+			return -1;
+		}
+
+		now += dt;
+	}
+
+	fclose(f);
+
+	return 0;
+}
+
+static void
+_range_setup(void)
+{
+	uint_fast8_t i;
+
+	range_reset();
+	for(i=0; i<SENSOR_N; i++)
+	{
+		range.thresh[i] = 0x80;
+		range.U[i] = 1.f / ADC_HALF_BITDEPTH;
+	}
+	range_curve_update();
+}
+
+static void
+_bench(Host_Engine *be, unsigned bumps)
+{
+	host_engines_disable();
+	if(be->enabled)
+		*be->enabled = 1;
+
+	cmc_init();
+
+	if(be->engine)
+	{
+		frame_cb_orig = be->engine->frame_cb;
+		be->engine->frame_cb = _frame_cb_count;
+	}
+	blobs_total = 0;
+
+	uint64_t bytes = 0;
+	double dt = 1.0 / config.sensors.rate;
+	OSC_Timetag now = 1.0;
+	OSC_Timetag offset = now + config.output.offset;
+
+	uint64_t t0 = _nsec();
+	uint32_t i;
+	for(i=0; i<n_frames; i++)
+	{
+		osc_data_t *buf = BUF_O_OFFSET(buf_o_ptr);
+		osc_data_t *end = BUF_O_MAX(buf_o_ptr);
+		osc_data_t *buf_ptr = cmc_process(now, offset, &frames[i*SENSOR_N], NULL, NULL, buf, end);
+
+		bytes += buf_ptr - buf;
+		now += dt;
+		offset += dt;
+	}
+	uint64_t t1 = _nsec();
+
+	if(be->engine)
+		be->engine->frame_cb = frame_cb_orig;
+
+	printf("%-10s %6u %12.1f %12.2f %12.1f\n", be->name, bumps,
+		(double)(t1 - t0) / n_frames,
+		(double)blobs_total / n_frames,
+		(double)bytes / n_frames);
+}
+
+#ifdef BENCHMARK_INTERPOLATION
+static const char *interpolation_names [] = {
+	[INTERPOLATION_NONE]			= "none",
+	[INTERPOLATION_QUADRATIC]	= "quadratic",
+	[INTERPOLATION_CATMULL]		= "catmullrom",
+	[INTERPOLATION_LAGRANGE]	= "lagrange"
+};
+
+// time the peak refinement kernels on their own
+static void
+_bench_kernels(void)
+{
+	uint8_t mode_orig = config.sensors.interpolation_mode;
+	uint_fast8_t mode;
+
+	host_engines_disable();
+
+	printf("%-10s %12s %12s\n", "# kernel", "cycles/peak", "peaks/frame");
+
+	for(mode=0; mode<sizeof(interpolation_names)/sizeof(const char *); mode++)
+	{
+		config.sensors.interpolation_mode = mode;
+		cmc_init();
+
+		cmc_interpolation_cycles = 0;
+		cmc_interpolation_peaks = 0;
+
+		double dt = 1.0 / config.sensors.rate;
+		OSC_Timetag now = 1.0;
+		OSC_Timetag offset = now + config.output.offset;
+
+		uint32_t i;
+		for(i=0; i<n_frames; i++)
+		{
+			osc_data_t *buf = BUF_O_OFFSET(buf_o_ptr);
+			osc_data_t *end = BUF_O_MAX(buf_o_ptr);
+
+			cmc_process(now, offset, &frames[i*SENSOR_N], NULL, NULL, buf, end);
+			now += dt;
+			offset += dt;
+		}
+
+		printf("%-10s %12.1f %12.2f\n", interpolation_names[mode],
+			cmc_interpolation_peaks ? (double)cmc_interpolation_cycles / cmc_interpolation_peaks : 0.0,
+			(double)cmc_interpolation_peaks / n_frames);
+	}
+
+	config.sensors.interpolation_mode = mode_orig;
+}
+#endif // BENCHMARK_INTERPOLATION
+
+static void
+_usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-f capture.chmc] [-n frames] [-b bumps] [-s seed] [-e engine] [-w capture.chmc] [-k] [-S]\n"
+		"  -f  take frames and calibration from capture file\n"
+		"  -n  number of synthetic frames (default 100000)\n"
+		"  -b  number of synthetic blobs (default 4, max %i)\n"
+		"  -s  seed of synthetic frames\n"
+		"  -e  only benchmark given engine\n"
+		"  -w  write frames to capture file\n"
+		"  -k  benchmark interpolation kernels (cycles/peak) instead of engines\n"
+		"  -S  sweep synthetic blobs from 1 to %i\n", argv0, BLOB_MAX, BLOB_MAX);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *path = NULL;
+	const char *only = NULL;
+	const char *save = NULL;
+#ifdef BENCHMARK_INTERPOLATION
+	uint_fast8_t kernels = 0;
+#endif
+	uint_fast8_t sweep = 0;
+	uint32_t n = 100000;
+	unsigned bumps = 4;
+	unsigned seed = 0;
+	int c;
+
+	while( (c = getopt(argc, argv, "f:n:b:s:e:w:kSh")) != -1)
+	{
+		switch(c)
+		{
+			case 'f':
+				path = optarg;
+				break;
+			case 'n':
+				n = strtoul(optarg, NULL, 10);
+				break;
+			case 'b':
+				bumps = strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 10);
+				break;
+			case 'e':
+				only = optarg;
+				break;
+			case 'w':
+				save = optarg;
+				break;
+			case 'k':
+#ifdef BENCHMARK_INTERPOLATION
+				kernels = 1;
+				break;
+#else
+				fprintf(stderr, "kernel cycle counters not compiled in, use 'make kernels'\n");
+				return -1;
+#endif
+			case 'S':
+				sweep = 1;
+				break;
+			default:
+				_usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if( (bumps < 1) || (bumps > BLOB_MAX) )
+	{
+		_usage(argv[0]);
+		return -1;
+	}
+
+	if(!path)
+		_range_setup();
+
+	if(sweep)
+	{
+		printf("# SENSOR_N=%i BLOB_MAX=%i frames=%u\n", SENSOR_N, BLOB_MAX, n);
+		printf("%-10s %6s %12s %12s %12s\n", "# engine", "bumps", "ns/frame", "blobs/frame", "bytes/frame");
+
+		for(bumps=1; bumps<=BLOB_MAX; bumps++)
+		{
+			if(_frames_synth(n, bumps, seed))
+				return -1;
+
+			Host_Engine *be;
+			for(be=host_engines; be->name; be++)
+				if(!only || !strcmp(only, be->name))
+					_bench(be, bumps);
+
+			free(frames);
+		}
+
+		return 0;
+	}
+
+	if(path ? _frames_load(path) : _frames_synth(n, bumps, seed))
+		return -1;
+	if(!n_frames)
+		return -1;
+	if(save && _frames_save(save))
+		return -1;
+
+	printf("# SENSOR_N=%i BLOB_MAX=%i frames=%u\n", SENSOR_N, BLOB_MAX, n_frames);
+#ifdef BENCHMARK_INTERPOLATION
+	if(kernels)
+	{
+		_bench_kernels();
+		free(frames);
+		return 0;
+	}
+#endif
+
+	printf("%-10s %6s %12s %12s %12s\n", "# engine", "bumps", "ns/frame", "blobs/frame", "bytes/frame");
+
+	Host_Engine *be;
+	for(be=host_engines; be->name; be++)
+		if(!only || !strcmp(only, be->name))
+			_bench(be, path ? 0 : bumps);
+
+	free(frames);
+
+	return 0;
+}
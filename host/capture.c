@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+#include <string.h>
+
+#include "capture.h"
+
+int
+capture_write_header(FILE *f, uint16_t rate, const Calibration *cal)
+{
+	Capture_Header hdr;
+
+	memset(&hdr, 0x0, sizeof(hdr));
+	memcpy(hdr.magic, CAPTURE_MAGIC, 4);
+	hdr.version = CAPTURE_VERSION;
+	hdr.sensor_n = SENSOR_N;
+	hdr.rate = rate;
+	hdr.range = *cal;
+
+	if(fwrite(&hdr, sizeof(hdr), 1, f) != 1)
+		return -1;
+
+	return 0;
+}
+
+int
+capture_write_frame(FILE *f, const Capture_Frame *frm)
+{
+	if(fwrite(frm, sizeof(Capture_Frame), 1, f) != 1)
+		return -1;
+
+	return 0;
+}
+
+int
+capture_read_header(FILE *f, Capture_Header *hdr)
+{
+	if(fread(hdr, sizeof(Capture_Header), 1, f) != 1)
+		return -1;
+
+	if(memcmp(hdr->magic, CAPTURE_MAGIC, 4) || (hdr->version != CAPTURE_VERSION) )
+		return -1; // not a capture file
+
+	if(hdr->sensor_n != SENSOR_N)
+		return -1; // recorded with a different number of sensors
+
+	return 0;
+}
+
+int
+capture_read_frame(FILE *f, Capture_Frame *frm)
+{
+	if(fread(frm, sizeof(Capture_Frame), 1, f) != 1)
+		return -1; // end of file or truncated last frame
+
+	return 0;
+}
+
+OSC_Timetag
+capture_timetag(uint64_t ntp)
+{
+	return (OSC_Timetag)(ntp >> 32) + (OSC_Timetag)(ntp & 0xffffffff) / 4294967296.0;
+}
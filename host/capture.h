@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <chimaera.h>
+#include <oscquery.h>
+#include <calibration.h>
+#include <osc.h>
+
+/*
+ * append-only sensor capture file
+ *
+ * [Capture_Header] [Capture_Frame] [Capture_Frame] ...
+ *
+ * all fields are little-endian, timetags are raw NTP 32.32 fixed-point
+ * as found on the wire, sensor values are relative to the quiescent
+ * values (e.g. adc_rela as fed into cmc_process).
+ */
+
+#define CAPTURE_MAGIC "CHMC"
+#define CAPTURE_VERSION 1
+
+typedef struct _Capture_Header Capture_Header;
+typedef struct _Capture_Frame Capture_Frame;
+
+struct _Capture_Header {
+	char magic [4];
+	uint16_t version;
+	uint16_t sensor_n;
+	uint16_t rate; // nominal update rate in Hz
+	uint16_t reserved;
+	Calibration range; // calibration snapshot at time of capture
+};
+
+struct _Capture_Frame {
+	uint32_t fid; // frame counter of device
+	uint32_t reserved;
+	uint64_t now; // timetag of acquisition
+	uint64_t offset; // timetag of output bundle
+	int16_t rela [SENSOR_N];
+};
+
+int capture_write_header(FILE *f, uint16_t rate, const Calibration *cal);
+int capture_write_frame(FILE *f, const Capture_Frame *frm);
+
+int capture_read_header(FILE *f, Capture_Header *hdr);
+int capture_read_frame(FILE *f, Capture_Frame *frm);
+
+OSC_Timetag capture_timetag(uint64_t ntp);
+
+#endif // _CAPTURE_H_
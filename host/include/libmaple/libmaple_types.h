@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+#ifndef _LIBMAPLE_LIBMAPLE_TYPES_H_
+#define _LIBMAPLE_LIBMAPLE_TYPES_H_
+
+#include <stdint.h>
+
+/*
+ * host stand-in for the libmaple type and attribute definitions
+ */
+
+#define __CCM__
+#define __CCM_TEXT__
+
+#ifndef __always_inline
+#	define __always_inline __attribute__((always_inline))
+#endif
+
+#ifndef __packed
+#	define __packed __attribute__((__packed__))
+#endif
+
+#define ASSERT(exp) ((void)(exp))
+
+#endif // _LIBMAPLE_LIBMAPLE_TYPES_H_
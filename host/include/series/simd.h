@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+#ifndef _SERIES_SIMD_H_
+#define _SERIES_SIMD_H_
+
+#include <stdint.h>
+
+/*
+ * plain C versions of the Cortex-M4 DSP instructions used by the firmware,
+ * bit-exact with the hardware, including the GE flags consumed by __sel
+ */
+
+static uint32_t __host_apsr_ge __attribute__((unused)); // per translation unit, lets unused flag updates be optimized out
+
+#define _SIMD_LO(x) ((int32_t)(int16_t)((x) & 0xffff))
+#define _SIMD_HI(x) ((int32_t)(int16_t)((x) >> 16))
+#define _SIMD_ULO(x) ((uint32_t)((x) & 0xffff))
+#define _SIMD_UHI(x) ((uint32_t)((x) >> 16))
+#define _SIMD_PACK(hi, lo) ((((uint32_t)(hi) & 0xffff) << 16) | ((uint32_t)(lo) & 0xffff))
+
+static inline int32_t
+_simd_sat16(int32_t v)
+{
+	return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+}
+
+static inline uint32_t
+__sadd16(uint32_t a, uint32_t b)
+{
+	int32_t lo = _SIMD_LO(a) + _SIMD_LO(b);
+	int32_t hi = _SIMD_HI(a) + _SIMD_HI(b);
+	__host_apsr_ge = (lo >= 0 ? 0x3 : 0x0) | (hi >= 0 ? 0xc : 0x0);
+	return _SIMD_PACK(hi, lo);
+}
+
+static inline uint32_t
+__ssub16(uint32_t a, uint32_t b)
+{
+	int32_t lo = _SIMD_LO(a) - _SIMD_LO(b);
+	int32_t hi = _SIMD_HI(a) - _SIMD_HI(b);
+	__host_apsr_ge = (lo >= 0 ? 0x3 : 0x0) | (hi >= 0 ? 0xc : 0x0);
+	return _SIMD_PACK(hi, lo);
+}
+
+static inline uint32_t
+__uadd16(uint32_t a, uint32_t b)
+{
+	uint32_t lo = _SIMD_ULO(a) + _SIMD_ULO(b);
+	uint32_t hi = _SIMD_UHI(a) + _SIMD_UHI(b);
+	__host_apsr_ge = (lo >= 0x10000 ? 0x3 : 0x0) | (hi >= 0x10000 ? 0xc : 0x0);
+	return _SIMD_PACK(hi, lo);
+}
+
+static inline uint32_t
+__usub16(uint32_t a, uint32_t b)
+{
+	int32_t lo = (int32_t)_SIMD_ULO(a) - (int32_t)_SIMD_ULO(b);
+	int32_t hi = (int32_t)_SIMD_UHI(a) - (int32_t)_SIMD_UHI(b);
+	__host_apsr_ge = (lo >= 0 ? 0x3 : 0x0) | (hi >= 0 ? 0xc : 0x0);
+	return _SIMD_PACK(hi, lo);
+}
+
+static inline uint32_t
+__qadd16(uint32_t a, uint32_t b)
+{
+	return _SIMD_PACK(_simd_sat16(_SIMD_HI(a) + _SIMD_HI(b)), _simd_sat16(_SIMD_LO(a) + _SIMD_LO(b)));
+}
+
+static inline uint32_t
+__qsub16(uint32_t a, uint32_t b)
+{
+	return _SIMD_PACK(_simd_sat16(_SIMD_HI(a) - _SIMD_HI(b)), _simd_sat16(_SIMD_LO(a) - _SIMD_LO(b)));
+}
+
+static inline uint32_t
+__shadd16(uint32_t a, uint32_t b)
+{
+	return _SIMD_PACK((_SIMD_HI(a) + _SIMD_HI(b)) >> 1, (_SIMD_LO(a) + _SIMD_LO(b)) >> 1);
+}
+
+static inline uint32_t
+__shsub16(uint32_t a, uint32_t b)
+{
+	return _SIMD_PACK((_SIMD_HI(a) - _SIMD_HI(b)) >> 1, (_SIMD_LO(a) - _SIMD_LO(b)) >> 1);
+}
+
+static inline uint32_t
+__sel(uint32_t a, uint32_t b)
+{
+	uint32_t r = 0;
+	uint_fast8_t i;
+	for(i=0; i<4; i++)
+		r |= ( (__host_apsr_ge >> i) & 1 ? a : b) & (0xffUL << (i*8));
+	return r;
+}
+
+static inline uint32_t
+__rev16(uint32_t a)
+{
+	return ((a & 0x00ff00ffUL) << 8) | ((a & 0xff00ff00UL) >> 8);
+}
+
+static inline uint32_t
+__rev(uint32_t a)
+{
+	return __builtin_bswap32(a);
+}
+
+static inline uint32_t
+__clz(uint32_t a)
+{
+	return a ? (uint32_t)__builtin_clz(a) : 32;
+}
+
+static inline uint32_t
+__ssat16(uint32_t a, uint_fast8_t n)
+{
+	int32_t max = (1L << (n - 1)) - 1;
+	int32_t min = -(1L << (n - 1));
+	int32_t lo = _SIMD_LO(a);
+	int32_t hi = _SIMD_HI(a);
+	lo = lo > max ? max : (lo < min ? min : lo);
+	hi = hi > max ? max : (hi < min ? min : hi);
+	return _SIMD_PACK(hi, lo);
+}
+
+static inline uint32_t
+__pkhbt(uint32_t a, uint32_t b, uint_fast8_t shift)
+{
+	return (a & 0xffff) | ((b << shift) & 0xffff0000UL);
+}
+
+static inline uint32_t
+__pkhtb(uint32_t a, uint32_t b, uint_fast8_t shift)
+{
+	return (a & 0xffff0000UL) | (((int32_t)b >> shift) & 0xffff);
+}
+
+static inline int32_t
+__smulbb(uint32_t a, uint32_t b)
+{
+	return _SIMD_LO(a) * _SIMD_LO(b);
+}
+
+static inline int32_t
+__smultt(uint32_t a, uint32_t b)
+{
+	return _SIMD_HI(a) * _SIMD_HI(b);
+}
+
+static inline int32_t
+__smuad(uint32_t a, uint32_t b)
+{
+	return _SIMD_LO(a) * _SIMD_LO(b) + _SIMD_HI(a) * _SIMD_HI(b);
+}
+
+static inline int32_t
+__smlad(uint32_t a, uint32_t b, int32_t acc)
+{
+	return acc + _SIMD_LO(a) * _SIMD_LO(b) + _SIMD_HI(a) * _SIMD_HI(b);
+}
+
+static inline int32_t
+__smlabb(uint32_t a, uint32_t b, int32_t acc)
+{
+	return acc + _SIMD_LO(a) * _SIMD_LO(b);
+}
+
+static inline int32_t
+__smlatt(uint32_t a, uint32_t b, int32_t acc)
+{
+	return acc + _SIMD_HI(a) * _SIMD_HI(b);
+}
+
+#endif // _SERIES_SIMD_H_
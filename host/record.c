@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+/*
+ * record /dump output of a device into a capture file
+ *
+ * queries the calibration snapshot and update rate over the configuration
+ * port first, then appends every received /dump frame together with its
+ * acquisition and bundle timetags until interrupted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <chimaera.h>
+#include <osc.h>
+#include <dump.h>
+
+#include "capture.h"
+
+static volatile sig_atomic_t done = 0;
+
+static uint8_t buf [0x10000];
+
+static void
+_sigint(int sig)
+{
+	(void)sig;
+	done = 1;
+}
+
+static uint64_t
+_ntp_get(const uint8_t *ptr)
+{
+	uint64_t t = 0;
+	uint_fast8_t i;
+	for(i=0; i<8; i++)
+		t = (t << 8) | ptr[i];
+
+	return t;
+}
+
+// send a configuration query and wait for its /success response
+static osc_data_t *
+_query(int sock, struct sockaddr_in *dev, const char *path, int32_t uuid, const char **fmt)
+{
+	osc_data_t *end = buf + sizeof(buf);
+	osc_data_t *buf_ptr = buf;
+
+	buf_ptr = osc_set_path(buf_ptr, end, path);
+	buf_ptr = osc_set_fmt(buf_ptr, end, "i");
+	buf_ptr = osc_set_int32(buf_ptr, end, uuid);
+
+	if(sendto(sock, buf, osc_len(buf_ptr, buf), 0, (struct sockaddr *)dev, sizeof(*dev)) < 0)
+		return NULL;
+
+	uint_fast8_t retry;
+	for(retry=0; retry<10; retry++)
+	{
+		ssize_t len = recv(sock, buf, sizeof(buf), 0);
+		if(len <= 0)
+			continue;
+		if(!osc_check_message(buf, len))
+			continue;
+
+		const char *rpath;
+		int32_t ruuid;
+		buf_ptr = osc_get_path(buf, &rpath);
+		buf_ptr = osc_get_fmt(buf_ptr, fmt);
+		buf_ptr = osc_get_int32(buf_ptr, &ruuid);
+		if(strcmp(rpath, "/success") || (ruuid != uuid) )
+			continue;
+
+		const char *s;
+		buf_ptr = osc_get_string(buf_ptr, &s); // path
+		(*fmt) += 3; // skip ',is'
+
+		return buf_ptr;
+	}
+
+	return NULL;
+}
+
+static int
+_calibration_query(int sock, struct sockaddr_in *dev, uint16_t *rate, Calibration *cal)
+{
+	osc_data_t *ptr;
+	const char *fmt;
+	OSC_Blob b;
+	int32_t i32;
+	uint_fast8_t i;
+
+	if(!(ptr = _query(sock, dev, "/sensors/rate", 1, &fmt)) || (*fmt != 'i') )
+		return -1;
+	osc_get_int32(ptr, &i32);
+	*rate = i32;
+
+	if(!(ptr = _query(sock, dev, "/calibration/quiescent", 2, &fmt)) || (*fmt != 'b') )
+		return -1;
+	osc_get_blob(ptr, &b);
+	if(b.size != sizeof(cal->qui))
+		return -1;
+	for(i=0; i<SENSOR_N; i++)
+		cal->qui[i] = ntoh(((uint16_t *)b.payload)[i]);
+
+	if(!(ptr = _query(sock, dev, "/calibration/threshold", 3, &fmt)) || (*fmt != 'b') )
+		return -1;
+	osc_get_blob(ptr, &b);
+	if(b.size != sizeof(cal->thresh))
+		return -1;
+	for(i=0; i<SENSOR_N; i++)
+		cal->thresh[i] = ntoh(((uint16_t *)b.payload)[i]);
+
+	if(!(ptr = _query(sock, dev, "/calibration/U", 4, &fmt)) || (*fmt != 'b') )
+		return -1;
+	osc_get_blob(ptr, &b);
+	if(b.size != sizeof(cal->U))
+		return -1;
+	for(i=0; i<SENSOR_N; i++)
+	{
+		uint32_t u = ntohl(((uint32_t *)b.payload)[i]);
+		memcpy(&cal->U[i], &u, sizeof(float));
+	}
+
+	if(!(ptr = _query(sock, dev, "/calibration/W", 5, &fmt)) || (*fmt != 'f') )
+		return -1;
+	osc_get_float(ptr, &cal->W);
+
+	const char *c_path [3] = {"/calibration/c0", "/calibration/c1", "/calibration/c2"};
+	for(i=0; i<3; i++)
+	{
+		if(!(ptr = _query(sock, dev, c_path[i], 6 + i, &fmt)) || (*fmt != 'f') )
+			return -1;
+		osc_get_float(ptr, &cal->C[i]);
+	}
+
+	return 0;
+}
+
+static int16_t delta_last [SENSOR_N]; // reference of delta encoded dump
+static int32_t delta_fid = -1; // ^frame id, -1 while waiting for a keyframe
+
+// decode /dump blob according to its header, returns 0 for undecodable frames
+static int
+_decode(Capture_Frame *frm, int32_t header, const OSC_Blob *b)
+{
+	const uint8_t *src = b->payload;
+	const uint8_t *end = src + b->size;
+	uint_fast8_t i;
+
+	if(header & DUMP_HEADER_WINDOW) // partial frames cannot be replayed
+		return 0;
+
+	switch(header & 0x7f) // encoding
+	{
+		case DUMP_ENCODING_RAW:
+			if(b->size != SENSOR_N*sizeof(int16_t))
+				return 0;
+			for(i=0; i<SENSOR_N; i++)
+				frm->rela[i] = ntoh(((uint16_t *)b->payload)[i]);
+			return 1;
+
+		case DUMP_ENCODING_INT8:
+			if(b->size != SENSOR_N*sizeof(int8_t))
+				return 0;
+			for(i=0; i<SENSOR_N; i++)
+				frm->rela[i] = (int16_t)((int8_t)src[i]) << ((header >> 8) & 0xff);
+			return 1;
+
+		case DUMP_ENCODING_DELTA:
+			if(header & DUMP_HEADER_KEYFRAME)
+				memset(delta_last, 0x0, sizeof(delta_last));
+			else if( (delta_fid < 0) || ((int32_t)frm->fid != delta_fid + 1) ) // lost frame, wait for next keyframe
+			{
+				delta_fid = -1;
+				return 0;
+			}
+			for(i=0; i<SENSOR_N; i++)
+			{
+				uint32_t z = 0;
+				uint_fast8_t shift = 0;
+				do
+				{
+					if(src >= end)
+					{
+						delta_fid = -1;
+						return 0;
+					}
+					z |= (uint32_t)(*src & 0x7f) << shift;
+					shift += 7;
+				} while(*src++ & 0x80);
+				delta_last[i] += (int16_t)((z >> 1) ^ -(z & 1)); // zig-zag decode
+				frm->rela[i] = delta_last[i];
+			}
+			delta_fid = frm->fid;
+			return 1;
+	}
+
+	return 0;
+}
+
+// walk (nested) bundles down to /dump messages
+static uint32_t
+_unroll(FILE *f, osc_data_t *ptr, size_t len, uint64_t offset)
+{
+	uint32_t n = 0;
+
+	if(!strncmp((const char *)ptr, "#bundle", 8))
+	{
+		osc_data_t *end = ptr + len;
+		offset = _ntp_get(ptr + 8);
+
+		for(ptr += 16; ptr < end; )
+		{
+			int32_t size;
+			ptr = osc_get_int32(ptr, &size);
+			n += _unroll(f, ptr, size, offset);
+			ptr += size;
+		}
+
+		return n;
+	}
+
+	const char *path;
+	const char *fmt;
+	int32_t fid;
+	int32_t header = DUMP_ENCODING_RAW;
+	OSC_Blob b;
+
+	ptr = osc_get_path(ptr, &path);
+	if(strcmp(path, "/dump"))
+		return 0;
+	ptr = osc_get_fmt(ptr, &fmt);
+	if(strncmp(fmt, ",ib", 3))
+		return 0;
+	ptr = osc_get_int32(ptr, &fid);
+	ptr = osc_get_blob(ptr, &b);
+
+	Capture_Frame frm;
+	memset(&frm, 0x0, sizeof(frm));
+	frm.fid = fid;
+	frm.offset = offset;
+	frm.now = fmt[3] == 't' ? _ntp_get(ptr) : offset; // older firmware lacks acquisition timetag
+	if(fmt[3] == 't' && fmt[4] == 'i')
+		osc_get_int32(ptr + 8, &header);
+
+	if(!_decode(&frm, header, &b))
+		return 0;
+	return capture_write_frame(f, &frm) ? 0 : 1;
+}
+
+static void
+_usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-d address] [-p port] [-c port] [-n frames] capture.chmc\n"
+		"  -d  device address (default 192.168.1.177)\n"
+		"  -p  output port to listen on (default 3333)\n"
+		"  -c  configuration port of device (default 4444)\n"
+		"  -n  stop after given number of frames (default: on SIGINT)\n", argv0);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *address = "192.168.1.177";
+	uint16_t port = 3333;
+	uint16_t config_port = 4444;
+	uint32_t n_max = 0;
+	int c;
+
+	while( (c = getopt(argc, argv, "d:p:c:n:h")) != -1)
+	{
+		switch(c)
+		{
+			case 'd':
+				address = optarg;
+				break;
+			case 'p':
+				port = strtoul(optarg, NULL, 10);
+				break;
+			case 'c':
+				config_port = strtoul(optarg, NULL, 10);
+				break;
+			case 'n':
+				n_max = strtoul(optarg, NULL, 10);
+				break;
+			default:
+				_usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if(optind >= argc)
+	{
+		_usage(argv[0]);
+		return -1;
+	}
+
+	struct sockaddr_in dev = {
+		.sin_family = AF_INET,
+		.sin_port = htons(config_port)
+	};
+	if(!inet_aton(address, &dev.sin_addr))
+	{
+		fprintf(stderr, "invalid address: %s\n", address);
+		return -1;
+	}
+
+	int conf = socket(AF_INET, SOCK_DGRAM, 0);
+	int outp = socket(AF_INET, SOCK_DGRAM, 0);
+	struct timeval tv = {.tv_sec = 1, .tv_usec = 0};
+	setsockopt(conf, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(outp, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	struct sockaddr_in any = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr.s_addr = htonl(INADDR_ANY)
+	};
+	int one = 1;
+	setsockopt(outp, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if(bind(outp, (struct sockaddr *)&any, sizeof(any)) < 0)
+	{
+		perror("bind");
+		return -1;
+	}
+
+	uint16_t rate;
+	Calibration cal;
+	if(_calibration_query(conf, &dev, &rate, &cal))
+	{
+		fprintf(stderr, "%s: calibration query failed\n", address);
+		return -1;
+	}
+
+	FILE *f = fopen(argv[optind], "wb");
+	if(!f || capture_write_header(f, rate, &cal))
+	{
+		perror(argv[optind]);
+		return -1;
+	}
+
+	signal(SIGINT, _sigint);
+
+	uint32_t n = 0;
+	while(!done && (!n_max || (n < n_max)) )
+	{
+		ssize_t len = recv(outp, buf, sizeof(buf), 0);
+		if(len <= 0)
+			continue;
+		if(!osc_check_packet(buf, len))
+			continue;
+
+		n += _unroll(f, buf, len, 1); // 1 := OSC_IMMEDIATE
+	}
+
+	fclose(f);
+	close(conf);
+	close(outp);
+
+	fprintf(stderr, "%u frames recorded\n", n);
+
+	return 0;
+}
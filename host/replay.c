@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+/*
+ * deterministic replay of a capture file
+ *
+ * restores the calibration snapshot and pushes every recorded frame with its
+ * original now/offset timetags through cmc_process. Emitted OSC packets can
+ * be written out ([uint32_t size] [packet] ...) to diff runs bit-exactly,
+ * per-frame processing time is reported to hunt down latency spikes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chimaera.h>
+#include <config.h>
+#include <wiz.h>
+#include <calibration.h>
+#include <cmc.h>
+
+#include <sensors.h>
+
+#include "capture.h"
+#include "select.h"
+
+static inline uint64_t
+_nsec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+static FILE *out = NULL;
+static osc_data_t *part_buf; // start of packet currently being built
+static uint32_t part_size = 0; // maximal packet size, 0: unlimited
+static uint64_t part_bytes = 0; // bytes of packets split off
+static uint32_t parts = 0; // number of packets split off
+
+static void
+_packet_write(osc_data_t *buf, uint32_t len)
+{
+	if(out && len)
+	{
+		fwrite(&len, sizeof(uint32_t), 1, out);
+		fwrite(buf, len, 1, out);
+	}
+}
+
+// mimics output_flush of the firmware
+static osc_data_t *
+_flush(osc_data_t *buf_ptr, osc_data_t **end)
+{
+	uint32_t len = osc_len(buf_ptr, part_buf);
+
+	if(buf_ptr == part_buf) // nothing to send yet
+		return buf_ptr;
+
+	_packet_write(part_buf, len);
+	part_bytes += len;
+	parts += len > 0;
+
+	*end = part_buf + part_size;
+	return part_buf;
+}
+
+static int
+_cmp_u32(const void *a, const void *b)
+{
+	uint32_t A = *(const uint32_t *)a;
+	uint32_t B = *(const uint32_t *)b;
+
+	return A < B ? -1 : (A > B ? 1 : 0);
+}
+
+static void
+_usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-e engine] [-d] [-t tolerance] [-D n] [-s size] [-o output] [-i mode] [-m] [-p] [-v] capture.chmc\n"
+		"  -e  enable output engine, may be given multiple times (default tuio2)\n"
+		"  -d  only send changed blobs (engines/<name>/deltas)\n"
+		"  -t  still blob tolerance of delta engines (engines/tolerance)\n"
+		"  -D  update blobs every nth frame (engines/<name>/decimation)\n"
+		"  -s  split frames into packets of at most size bytes like the output socket\n"
+		"  -o  write emitted OSC packets to file\n"
+		"  -i  interpolation mode: 0 none, 1 quadratic, 2 catmullrom, 3 lagrange\n"
+		"  -m  hand a precomputed mask to cmc_process like the fused adc_fill does\n"
+		"  -p  extrapolate blobs to the output offset\n"
+		"  -v  print per-frame fid, blob bytes and processing time\n", argv0);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *out_path = NULL;
+	uint_fast8_t verbose = 0;
+	uint_fast8_t fused = 0;
+	uint_fast8_t selected = 0;
+	uint_fast8_t deltas = 0;
+	uint_fast8_t decimation = 1;
+	int c;
+
+	host_engines_disable();
+
+	while( (c = getopt(argc, argv, "e:dt:D:s:o:i:mpvh")) != -1)
+	{
+		switch(c)
+		{
+			case 'e':
+			{
+				Host_Engine *he = host_engine_find(optarg);
+				if(!he)
+				{
+					fprintf(stderr, "unknown engine: %s\n", optarg);
+					return -1;
+				}
+				if(he->enabled)
+					*he->enabled = 1;
+				selected = 1;
+				break;
+			}
+			case 'd':
+				deltas = 1;
+				break;
+			case 't':
+				config.output.tolerance = strtof(optarg, NULL);
+				break;
+			case 'D':
+				decimation = strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				part_size = strtoul(optarg, NULL, 10);
+				break;
+			case 'o':
+				out_path = optarg;
+				break;
+			case 'i':
+				config.sensors.interpolation_mode = strtoul(optarg, NULL, 10);
+				break;
+			case 'm':
+				fused = 1;
+				break;
+			case 'p':
+				config.sensors.prediction = 1;
+				break;
+			case 'v':
+				verbose = 1;
+				break;
+			default:
+				_usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if(optind >= argc)
+	{
+		_usage(argv[0]);
+		return -1;
+	}
+
+	if(!selected)
+		config.tuio2.enabled = 1;
+
+	Host_Engine *he;
+	for(he=host_engines; he->name; he++)
+	{
+		if(he->deltas)
+			*he->deltas = deltas;
+		if(he->decimation)
+			*he->decimation = decimation;
+	}
+
+	FILE *f = fopen(argv[optind], "rb");
+	if(!f)
+	{
+		perror(argv[optind]);
+		return -1;
+	}
+
+	Capture_Header hdr;
+	if(capture_read_header(f, &hdr))
+	{
+		fprintf(stderr, "%s: no capture file for SENSOR_N=%i\n", argv[optind], SENSOR_N);
+		fclose(f);
+		return -1;
+	}
+
+	if(out_path && !(out = fopen(out_path, "wb")) )
+	{
+		perror(out_path);
+		fclose(f);
+		return -1;
+	}
+
+	// restore device state at time of capture
+	range = hdr.range;
+	range_curve_update();
+	config.sensors.rate = hdr.rate;
+	cmc_init();
+	if(part_size)
+		cmc_flush_cb = _flush;
+
+	uint32_t *lat = NULL;
+	uint32_t n = 0;
+	uint32_t max = 0;
+	uint64_t bytes = 0;
+	uint32_t fid_max = 0;
+	uint32_t lat_max = 0;
+
+	Capture_Frame frm;
+	CMC_Mask mask;
+	while(!capture_read_frame(f, &frm))
+	{
+		OSC_Timetag now = capture_timetag(frm.now);
+		OSC_Timetag offset = capture_timetag(frm.offset);
+
+		osc_data_t *buf = BUF_O_OFFSET(buf_o_ptr);
+		osc_data_t *end = part_size ? buf + part_size : BUF_O_MAX(buf_o_ptr);
+
+		part_buf = buf;
+		if(fused)
+		{
+			uint32_t *rela_vec32 = (uint32_t *)frm.rela;
+			uint32_t *thresh_vec32 = (uint32_t *)range.thresh;
+			uint_fast8_t i;
+
+			cmc_mask_clear(&mask);
+			for(i=0; i<SENSOR_N/2; i++)
+				cmc_mask_pair(&mask, i, rela_vec32[i], thresh_vec32[i]);
+		}
+
+		uint64_t t0 = _nsec();
+		osc_data_t *buf_ptr = cmc_process(now, offset, frm.rela, fused ? &mask : NULL, NULL, buf, end);
+		uint64_t t1 = _nsec();
+
+		uint32_t len = osc_len(buf_ptr, buf);
+		uint32_t dt = t1 - t0;
+
+		if(n == max)
+		{
+			max = max ? max*2 : 0x1000;
+			lat = realloc(lat, max*sizeof(uint32_t));
+			if(!lat)
+				break;
+		}
+		lat[n++] = dt;
+		bytes += len;
+
+		if(dt > lat_max)
+		{
+			lat_max = dt;
+			fid_max = frm.fid;
+		}
+
+		if(verbose)
+			printf("%u %u %u\n", frm.fid, len, dt);
+
+		_packet_write(buf, len);
+	}
+
+	fclose(f);
+	if(out)
+		fclose(out);
+
+	if(!n)
+	{
+		free(lat);
+		return 0;
+	}
+
+	qsort(lat, n, sizeof(uint32_t), _cmp_u32);
+
+	uint64_t sum = 0;
+	uint32_t i;
+	for(i=0; i<n; i++)
+		sum += lat[i];
+
+	printf("# frames=%u rate=%u bytes/frame=%.1f\n", n, hdr.rate, (double)(bytes + part_bytes) / n);
+	if(part_size)
+		printf("# split off packets=%u\n", parts);
+	printf("# ns/frame: mean=%.1f p50=%u p99=%u max=%u (fid %u)\n",
+		(double)sum / n, lat[n/2], lat[n*99/100], lat_max, fid_max);
+
+	free(lat);
+
+	return 0;
+}
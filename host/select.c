@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+#include <string.h>
+
+#include <chimaera.h>
+#include <config.h>
+
+#include <tuio2.h>
+#include <tuio1.h>
+#include <scsynth.h>
+#include <oscmidi.h>
+#include <dummy.h>
+#include <custom.h>
+
+#include "select.h"
+
+Host_Engine host_engines [] = {
+	{"none", NULL, NULL, NULL, NULL},
+	{"tuio2", &config.tuio2.enabled, &config.tuio2.deltas, &config.tuio2.decimation, &tuio2_engine},
+	{"tuio1", &config.tuio1.enabled, &config.tuio1.deltas, &config.tuio1.decimation, &tuio1_engine},
+	{"scsynth", &config.scsynth.enabled, &config.scsynth.deltas, &config.scsynth.decimation, &scsynth_engine},
+	{"oscmidi", &config.oscmidi.enabled, &config.oscmidi.deltas, &config.oscmidi.decimation, &oscmidi_engine},
+	{"dummy", &config.dummy.enabled, &config.dummy.deltas, &config.dummy.decimation, &dummy_engine},
+	{"custom", &config.custom.enabled, &config.custom.deltas, &config.custom.decimation, &custom_engine},
+	{NULL, NULL, NULL, NULL, NULL} // terminator
+};
+
+Host_Engine *
+host_engine_find(const char *name)
+{
+	Host_Engine *he;
+	for(he=host_engines; he->name; he++)
+		if(!strcmp(he->name, name))
+			return he;
+
+	return NULL;
+}
+
+void
+host_engines_disable(void)
+{
+	Host_Engine *he;
+	for(he=host_engines; he->name; he++)
+		if(he->enabled)
+			*he->enabled = 0;
+}
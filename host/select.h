@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+#ifndef _SELECT_H_
+#define _SELECT_H_
+
+#include <cmc.h>
+
+typedef struct _Host_Engine Host_Engine;
+
+struct _Host_Engine {
+	const char *name;
+	uint8_t *enabled;
+	uint8_t *deltas;
+	uint8_t *decimation;
+	CMC_Engine *engine;
+};
+
+extern Host_Engine host_engines [];
+
+Host_Engine *host_engine_find(const char *name);
+void host_engines_disable(void);
+
+#endif // _SELECT_H_
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <chimaera.h>
+#include <config.h>
+#include <eeprom.h>
+#include <debug.h>
+#include <cmc.h>
+#include <midi.h>
+#include <sensors.h>
+
+/*
+ * host stand-ins for the parts of the firmware which talk to hardware:
+ * configuration defaults, OSC responder, EEPROM and debug output.
+ */
+
+uint_fast8_t buf_o_ptr = 0;
+uint8_t buf_o[2][CHIMAERA_BUFSIZE];
+
+const char *success_str = "/success";
+const char *fail_str = "/fail";
+
+// factory settings of the processing pipeline, mirrors config/config.c
+Config config = {
+	.version = {
+		.revision = REVISION,
+		.major = VERSION_MAJOR,
+		.minor = VERSION_MINOR,
+		.patch = VERSION_PATCH
+	},
+
+	.name = {'c', 'h', 'i', 'm', 'a', 'e', 'r', 'a', '\0'},
+
+	.oscmidi = {
+		.enabled = 0,
+		.multi = 1,
+		.format = OSC_MIDI_FORMAT_MIDI,
+		.mpe = 0,
+		.path = {'/', 'm', 'i', 'd', 'i', '\0'}
+	},
+
+	.output = {
+		.osc = {
+			.mode = OSC_MODE_UDP,
+			.server = 0
+		},
+		.offset = 0.002, // := 2ms offset
+		.parallel = 1,
+		.keepalive = 32,
+		.tolerance = 0.002f
+	},
+
+	.sensors = {
+		.smoothing = 0x1000, // := 1/8, the former 8 sample moving average
+		.interpolation_mode = INTERPOLATION_QUADRATIC,
+		.velocity_stiffness = 32,
+		.rate = 2000
+	},
+
+	.groups = {
+		[0] = {
+			.x0 = 0.f,
+			.x1 = 1.f,
+			.m = 1.f,
+			.gid = 0,
+			.pid = CMC_SOUTH
+		},
+		[1] = {
+			.x0 = 0.f,
+			.x1 = 1.f,
+			.m = 1.f,
+			.gid = 1,
+			.pid = CMC_NORTH
+		}
+	},
+
+#define SYNTH_DEF(C, N) \
+		{ \
+			.name = {'s', 'y', 'n', 't', 'h', '_', C, '\0'}, \
+			.sid = 200, \
+			.group = 100 + N, \
+			.out = N, \
+			.arg = 0, \
+			.alloc = 1, \
+			.gate = 1, \
+			.add_action = SCSYNTH_ADD_TO_HEAD, \
+			.is_group = 0 \
+		}
+	.scsynth_groups = {
+		[0] = SYNTH_DEF('0', 0),
+		[1] = SYNTH_DEF('1', 1),
+		[2] = SYNTH_DEF('2', 2),
+		[3] = SYNTH_DEF('3', 3),
+		[4] = SYNTH_DEF('4', 4),
+		[5] = SYNTH_DEF('5', 5),
+		[6] = SYNTH_DEF('6', 6),
+		[7] = SYNTH_DEF('7', 7)
+	},
+#undef SYNTH_DEF
+
+#define MIDI_DEF \
+		{ \
+			.mapping = OSC_MIDI_MAPPING_CONTROL_CHANGE, \
+			.control = 0x46, \
+			.offset = MIDI_BOT, \
+			.range = MIDI_RANGE \
+		}
+	.oscmidi_groups = {
+		[0] = MIDI_DEF,
+		[1] = MIDI_DEF,
+		[2] = MIDI_DEF,
+		[3] = MIDI_DEF,
+		[4] = MIDI_DEF,
+		[5] = MIDI_DEF,
+		[6] = MIDI_DEF,
+		[7] = MIDI_DEF
+	}
+#undef MIDI_DEF
+};
+
+const OSC_Query_Argument config_boolean_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
+};
+
+const OSC_Query_Argument config_decimation_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Frames", OSC_QUERY_MODE_RW, 1, 255, 1)
+};
+
+const OSC_Query_Argument config_destination_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Output socket (0) or fan-out (1..)", OSC_QUERY_MODE_RW, 0, OUTPUT_FANOUT_MAX, 1)
+};
+
+uint16_t
+CONFIG_SUCCESS(const char *fmt, ...)
+{
+	osc_data_t *buf = BUF_O_OFFSET(buf_o_ptr);
+	osc_data_t *end = BUF_O_MAX(buf_o_ptr);
+	osc_data_t *buf_ptr;
+
+  va_list args;
+  va_start(args, fmt);
+	buf_ptr = osc_set_varlist(buf, end, success_str, fmt, args);
+  va_end(args);
+
+	return osc_len(buf_ptr, buf);
+}
+
+uint16_t
+CONFIG_FAIL(const char *fmt, ...)
+{
+	osc_data_t *buf = BUF_O_OFFSET(buf_o_ptr);
+	osc_data_t *end = BUF_O_MAX(buf_o_ptr);
+	osc_data_t *buf_ptr;
+
+  va_list args;
+  va_start(args, fmt);
+	buf_ptr = osc_set_varlist(buf, end, fail_str, fmt, args);
+  va_end(args);
+
+	return osc_len(buf_ptr, buf);
+}
+
+void
+CONFIG_SEND(uint16_t size)
+{
+	(void)size; // there is no network on the host
+}
+
+uint_fast8_t
+config_check_bool(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, uint8_t *booly)
+{
+	(void)path;
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc > 1)
+	{
+		int32_t i;
+		buf_ptr = osc_get_int32(buf_ptr, &i);
+		*booly = i != 0 ? 1 : 0;
+	}
+
+	return 1;
+}
+
+uint_fast8_t
+config_check_uint8(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, uint8_t *val)
+{
+	(void)path;
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc > 1)
+	{
+		int32_t i;
+		buf_ptr = osc_get_int32(buf_ptr, &i);
+		*val = i;
+	}
+
+	return 1;
+}
+
+uint_fast8_t
+config_check_uint16(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, uint16_t *val)
+{
+	(void)path;
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc > 1)
+	{
+		int32_t i;
+		buf_ptr = osc_get_int32(buf_ptr, &i);
+		*val = i;
+	}
+
+	return 1;
+}
+
+uint_fast8_t
+config_check_float(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, float *val)
+{
+	(void)path;
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc > 1)
+	{
+		float f;
+		buf_ptr = osc_get_float(buf_ptr, &f);
+		*val = f;
+	}
+
+	return 1;
+}
+
+// EEPROM is emulated in RAM
+static uint8_t eeprom_mem [EEPROM_SIZE];
+EEPROM_24xx *eeprom_24LC64 = NULL;
+
+void
+eeprom_bulk_write(EEPROM_24xx *eeprom, uint16_t addr, uint8_t *bulk, uint16_t len)
+{
+	(void)eeprom;
+	if(addr + len <= EEPROM_SIZE)
+		memcpy(&eeprom_mem[addr], bulk, len);
+}
+
+void
+eeprom_bulk_read(EEPROM_24xx *eeprom, uint16_t addr, uint8_t *bulk, uint16_t len)
+{
+	(void)eeprom;
+	if(addr + len <= EEPROM_SIZE)
+		memcpy(bulk, &eeprom_mem[addr], len);
+}
+
+// no background health statistics on the host, thresholds are never fed
+void
+sensors_health_restore(void)
+{
+}
+
+void
+DEBUG(const char *fmt, ...)
+{
+	(void)fmt; // debug output is dropped on the host
+}
+
+// newlib provides it, older glibc does not
+__attribute__((weak)) size_t
+strlcpy(char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if(size)
+	{
+		size_t n = len < size - 1 ? len : size - 1;
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+
+	return len;
+}
@@ -0,0 +1,525 @@
+/*
+ * Copyright (c) 2015 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ *
+ * This is free software: you can redistribute it and/or modify
+ * it under the terms of the Artistic License 2.0 as published by
+ * The Perl Foundation.
+ *
+ * This source is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Artistic License 2.0 for more details.
+ *
+ * You should have received a copy of the Artistic License 2.0
+ * along the source as a COPYING file. If not, obtain it from
+ * http://www.perlfoundation.org/artistic_license_2_0.
+ */
+
+
+/*
+ * synthetic magnetic-field frames from scripted virtual magnets
+ *
+ * every magnet has a position, height, polarity and velocity. The height of
+ * a magnet maps linearly to its distance from the array, the proximity seen
+ * by each sensor is run backwards through the distance/flux curve of
+ * range_curve_update() and the per-sensor range.U/range.W terms to get its
+ * value, fields of several magnets add up and gaussian noise is added on top.
+ *
+ * the frames are pushed through cmc_process and the tracked blobs are
+ * compared against the magnets: position and height error, missed magnets,
+ * ghost blobs, polarity errors and id switches while a magnet stays put.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chimaera.h>
+#include <config.h>
+#include <wiz.h>
+#include <calibration.h>
+#include <cmc.h>
+
+#include <sensors.h>
+
+#include "capture.h"
+#include "select.h"
+
+#define SYNTH_MAGNET_MAX 8
+#define SYNTH_FULL_SCALE 1800 // sensor value in LSB at maximal flux
+#define SYNTH_THRESH 60 // sensor value in LSB at zero normalized flux
+#define SYNTH_Y_MIN 0.1f // magnets lower than this are not expected to be tracked
+#define SYNTH_GATE 3.f // maximal distance of a blob to its magnet in sensor pitches
+
+typedef struct _Synth_Magnet Synth_Magnet;
+typedef struct _Synth_Script Synth_Script;
+typedef struct _Synth_Blob Synth_Blob;
+typedef struct _Synth_Stats Synth_Stats;
+
+struct _Synth_Magnet {
+	float t0, t1; // lifetime in s
+	float x, y; // position and height at t0, normalized
+	float vx, vy; // velocity in 1/s
+	uint_fast8_t north; // polarity
+};
+
+struct _Synth_Script {
+	const char *name;
+	float duration; // s
+	uint_fast8_t n;
+	Synth_Magnet magnets [SYNTH_MAGNET_MAX];
+};
+
+struct _Synth_Blob {
+	uint32_t sid;
+	uint16_t pid;
+	float x, y;
+};
+
+struct _Synth_Stats {
+	uint32_t frames;
+	uint32_t samples; // matched magnet frames
+	uint32_t expected; // magnet frames expected to be tracked
+	uint32_t missed;
+	uint32_t ghosts;
+	uint32_t polarity;
+	uint32_t switches;
+	double x_sum2, x_max; // in sensor pitches
+	double y_sum2, y_max;
+	uint64_t ns;
+};
+
+static const Synth_Script scripts [] = {
+	{
+		.name = "slide", .duration = 2.f, .n = 1,
+		.magnets = {
+			{0.f, 2.f, 0.1f, 0.6f, 0.4f, 0.f, 0}
+		}
+	},
+	{
+		.name = "tap", .duration = 1.f, .n = 2,
+		.magnets = {
+			{0.f, 0.5f, 0.5f, 0.1f, 0.f, 1.6f, 0},
+			{0.5f, 1.f, 0.5f, 0.9f, 0.f, -1.6f, 0}
+		}
+	},
+	{
+		.name = "fast", .duration = 0.4f, .n = 1,
+		.magnets = {
+			{0.f, 0.4f, 0.05f, 0.7f, 2.25f, 0.f, 1}
+		}
+	},
+	{
+		.name = "pair", .duration = 1.5f, .n = 2,
+		.magnets = {
+			{0.f, 1.5f, 0.3f, 0.7f, 0.1f, 0.f, 0},
+			{0.f, 1.5f, 0.7f, 0.7f, -0.1f, 0.f, 1}
+		}
+	},
+	{
+		.name = "chord", .duration = 1.f, .n = 5,
+		.magnets = {
+			{0.f, 1.f, 0.1f, 0.5f, 0.f, 0.f, 0},
+			{0.f, 1.f, 0.3f, 0.6f, 0.f, 0.f, 1},
+			{0.f, 1.f, 0.5f, 0.7f, 0.f, 0.f, 0},
+			{0.f, 1.f, 0.7f, 0.8f, 0.f, 0.f, 1},
+			{0.f, 1.f, 0.9f, 0.9f, 0.f, 0.f, 0}
+		}
+	},
+	{
+		.name = NULL // terminator
+	}
+};
+
+static float z_min = 1.f; // distance at full height in sensor pitches
+static float z_range = 4.f; // distance from full to zero height in sensor pitches
+static float noise = 2.f; // RMS sensor noise in LSB
+static float gain = 0.f; // relative spread of per-sensor gains
+
+static Synth_Blob blobs [BLOB_MAX];
+static uint_fast8_t n_blobs;
+
+static CMC_Engine engine_orig;
+
+static uint32_t rng = 1;
+
+// xorshift32, reproducible on every host
+static inline float
+_uniform(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return (rng >> 8) * (1.f / (1 << 24));
+}
+
+static inline float
+_gauss(void)
+{
+	float u = _uniform() + 1e-7f;
+	float v = _uniform();
+	return sqrtf(-2.f * logf(u)) * cosf(2.f * M_PI * v);
+}
+
+// same as _curve in calibration.c
+static inline float
+_curve(float x)
+{
+	float y = range.C[0]*cbrtf(x) + range.C[1]*sqrtf(x) + range.C[2]*x;
+	return y < 0.f ? 0.f :(y > 1.f ? 1.f : y);
+}
+
+// normalized flux for given proximity, by bisection of the monotonic curve
+static float
+_curve_inverse(float p)
+{
+	float lo = 0.f;
+	float hi = 1.f;
+	uint_fast8_t i;
+
+	for(i=0; i<24; i++)
+	{
+		float mid = 0.5f * (lo + hi);
+		if(_curve(mid) < p)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return 0.5f * (lo + hi);
+}
+
+// calibration of the virtual device, with optional spread of per-sensor gains
+static void
+_range_setup(void)
+{
+	uint_fast8_t i;
+	float U = 1.f / (SYNTH_FULL_SCALE - SYNTH_THRESH); // aval*U - W == 1 at full scale
+	float W = SYNTH_THRESH * U; // aval*U - W == 0 at threshold
+
+	range_reset();
+	range.W = W;
+	for(i=0; i<SENSOR_N; i++)
+	{
+		range.U[i] = U * (1.f + gain * (2.f*_uniform() - 1.f));
+		range.thresh[i] = W / range.U[i] + 0.5f;
+	}
+	range_curve_update();
+}
+
+// sensor values of all magnets alive at time t
+static void
+_frame_synth(const Synth_Script *scr, float t, int16_t *rela)
+{
+	float field [SENSOR_N];
+	uint_fast8_t i, m;
+
+	memset(field, 0x0, sizeof(field));
+
+	for(m=0; m<scr->n; m++)
+	{
+		const Synth_Magnet *mag = &scr->magnets[m];
+		if( (t < mag->t0) || (t >= mag->t1) )
+			continue;
+
+		float x = (mag->x + mag->vx * (t - mag->t0)) * SENSOR_N; // in sensor pitches
+		float y = mag->y + mag->vy * (t - mag->t0);
+		float z = z_min + (1.f - y) * z_range;
+		float z_max = z_min + z_range;
+
+		for(i=0; i<SENSOR_N; i++)
+		{
+			float dx = x - (i + 0.5f);
+			float r = sqrtf(dx*dx + z*z);
+			float aval;
+
+			if(r < z_max) // within range, invert distance/flux model
+			{
+				float p = 1.f - (r - z_min) / z_range;
+				aval = (_curve_inverse(p > 1.f ? 1.f : p) + range.W) / range.U[i];
+			}
+			else // out of range, dipole falloff from threshold level
+			{
+				float q = z_max / r;
+				aval = range.W / range.U[i] * q*q*q;
+			}
+
+			field[i] += mag->north ? -aval : aval;
+		}
+	}
+
+	for(i=0; i<SENSOR_N; i++)
+	{
+		float v = field[i] + noise * _gauss();
+		v = v > ADC_HALF_BITDEPTH - 1 ? ADC_HALF_BITDEPTH - 1 : (v < -ADC_HALF_BITDEPTH ? -ADC_HALF_BITDEPTH : v);
+		rela[i] = lrintf(v);
+	}
+}
+
+// interposed blob callbacks of the dummy engine, tracking the set of blobs
+static osc_data_t *
+_on_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
+{
+	if(n_blobs < BLOB_MAX)
+	{
+		Synth_Blob *blob = &blobs[n_blobs++];
+		blob->sid = bev->sid;
+		blob->pid = bev->pid;
+		blob->x = bev->x;
+		blob->y = bev->y;
+	}
+
+	return buf;
+}
+
+static osc_data_t *
+_set_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
+{
+	uint_fast8_t b;
+	for(b=0; b<n_blobs; b++)
+		if(blobs[b].sid == bev->sid)
+		{
+			blobs[b].x = bev->x;
+			blobs[b].y = bev->y;
+			break;
+		}
+
+	return buf;
+}
+
+static osc_data_t *
+_off_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
+{
+	uint_fast8_t b;
+	for(b=0; b<n_blobs; b++)
+		if(blobs[b].sid == bev->sid)
+		{
+			blobs[b] = blobs[--n_blobs];
+			break;
+		}
+
+	return buf;
+}
+
+static inline uint64_t
+_nsec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+// compare tracked blobs against magnets at time t
+static void
+_frame_score(const Synth_Script *scr, float t, int64_t *sids, Synth_Stats *st)
+{
+	uint8_t used [BLOB_MAX];
+	uint_fast8_t m, b;
+
+	memset(used, 0x0, sizeof(used));
+
+	for(m=0; m<scr->n; m++)
+	{
+		const Synth_Magnet *mag = &scr->magnets[m];
+		if( (t < mag->t0) || (t >= mag->t1) )
+			continue;
+
+		float x = mag->x + mag->vx * (t - mag->t0);
+		float y = mag->y + mag->vy * (t - mag->t0);
+		int best = -1;
+		float best_dx = SYNTH_GATE / SENSOR_N;
+
+		for(b=0; b<n_blobs; b++)
+		{
+			float dx = fabsf(blobs[b].x - x);
+			if(!used[b] && (dx < best_dx) )
+			{
+				best = b;
+				best_dx = dx;
+			}
+		}
+
+		if(y < SYNTH_Y_MIN) // too far off, a matching blob is neither counted nor missed
+		{
+			if(best >= 0)
+				used[best] = 1;
+			continue;
+		}
+
+		st->expected++;
+		if(best < 0)
+		{
+			st->missed++;
+			continue;
+		}
+
+		Synth_Blob *blob = &blobs[best];
+		used[best] = 1;
+
+		double ex = (blob->x - x) * SENSOR_N;
+		double ey = blob->y - y;
+		st->samples++;
+		st->x_sum2 += ex*ex;
+		st->y_sum2 += ey*ey;
+		st->x_max = fmax(st->x_max, fabs(ex));
+		st->y_max = fmax(st->y_max, fabs(ey));
+
+		if(blob->pid != (mag->north ? CMC_NORTH : CMC_SOUTH) )
+			st->polarity++;
+
+		if( (sids[m] >= 0) && (sids[m] != blob->sid) )
+			st->switches++;
+		sids[m] = blob->sid;
+	}
+
+	for(b=0; b<n_blobs; b++)
+		if(!used[b])
+			st->ghosts++;
+}
+
+static void
+_run(const Synth_Script *scr, Synth_Stats *st)
+{
+	int64_t sids [SYNTH_MAGNET_MAX];
+	int16_t rela [SENSOR_N] __attribute__((aligned(4)));
+	double dt = 1.0 / config.sensors.rate;
+	OSC_Timetag now = 1.0;
+	OSC_Timetag offset = now + config.output.offset;
+	uint32_t n = scr->duration * config.sensors.rate;
+	uint32_t i;
+
+	memset(st, 0x0, sizeof(Synth_Stats));
+	memset(sids, 0xff, sizeof(sids)); // no id yet
+	n_blobs = 0;
+
+	cmc_init();
+
+	for(i=0; i<n; i++)
+	{
+		float t = i * dt;
+		osc_data_t *buf = BUF_O_OFFSET(buf_o_ptr);
+		osc_data_t *end = BUF_O_MAX(buf_o_ptr);
+
+		_frame_synth(scr, t, rela);
+
+		uint64_t t0 = _nsec();
+		cmc_process(now, offset, rela, NULL, NULL, buf, end);
+		st->ns += _nsec() - t0;
+
+		_frame_score(scr, t, sids, st);
+		st->frames++;
+
+		now += dt;
+		offset += dt;
+	}
+}
+
+static void
+_usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-s script] [-n noise] [-g gain] [-z range] [-i mode] [-r rate] [-p] [-S seed]\n"
+		"  -s  only run given script: slide, tap, fast, pair or chord\n"
+		"  -n  RMS sensor noise in LSB (default 2)\n"
+		"  -g  relative spread of per-sensor gains (default 0)\n"
+		"  -z  distance from full to zero height in sensor pitches (default 4)\n"
+		"  -i  interpolation mode: 0 none, 1 quadratic, 2 catmullrom, 3 lagrange\n"
+		"  -r  update rate in Hz (default 2000)\n"
+		"  -p  extrapolate blobs to the output offset\n"
+		"  -S  seed of noise and gain spread\n", argv0);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *only = NULL;
+	int c;
+
+	while( (c = getopt(argc, argv, "s:n:g:z:i:r:pS:h")) != -1)
+	{
+		switch(c)
+		{
+			case 's':
+				only = optarg;
+				break;
+			case 'n':
+				noise = strtof(optarg, NULL);
+				break;
+			case 'g':
+				gain = strtof(optarg, NULL);
+				break;
+			case 'z':
+				z_range = strtof(optarg, NULL);
+				break;
+			case 'i':
+				config.sensors.interpolation_mode = strtoul(optarg, NULL, 10);
+				break;
+			case 'r':
+				config.sensors.rate = strtoul(optarg, NULL, 10);
+				break;
+			case 'p':
+				config.sensors.prediction = 1;
+				break;
+			case 'S':
+				rng = strtoul(optarg, NULL, 10) | 1; // xorshift must not be seeded with zero
+				break;
+			default:
+				_usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if( (z_range <= 0.f) || !config.sensors.rate)
+	{
+		_usage(argv[0]);
+		return -1;
+	}
+
+	// dummy engine with interposed blob callbacks
+	Host_Engine *he = host_engine_find("dummy");
+	host_engines_disable();
+	*he->enabled = 1;
+	engine_orig = *he->engine;
+	he->engine->on_cb = _on_cb;
+	he->engine->set_cb = _set_cb;
+	he->engine->off_cb = _off_cb;
+
+	_range_setup();
+
+	printf("# SENSOR_N=%i BLOB_MAX=%i rate=%u noise=%.2f gain=%.3f range=%.1f\n",
+		SENSOR_N, BLOB_MAX, config.sensors.rate, noise, gain, z_range);
+	printf("%-8s %7s %9s %9s %9s %9s %7s %7s %7s %7s %9s\n", "# script", "frames",
+		"x_rms", "x_max", "y_rms", "y_max", "missed", "ghosts", "polar", "switch", "ns/frame");
+
+	const Synth_Script *scr;
+	uint_fast8_t found = 0;
+	for(scr=scripts; scr->name; scr++)
+	{
+		if(only && strcmp(only, scr->name))
+			continue;
+		found = 1;
+
+		Synth_Stats st;
+		_run(scr, &st);
+
+		printf("%-8s %7u %9.4f %9.4f %9.4f %9.4f %7u %7u %7u %7u %9.1f\n", scr->name, st.frames,
+			st.samples ? sqrt(st.x_sum2 / st.samples) : 0.0, st.x_max,
+			st.samples ? sqrt(st.y_sum2 / st.samples) : 0.0, st.y_max,
+			st.missed, st.ghosts, st.polarity, st.switches,
+			st.frames ? (double)st.ns / st.frames : 0.0);
+	}
+
+	*he->engine = engine_orig;
+
+	if(!found)
+	{
+		fprintf(stderr, "unknown script: %s\n", only);
+		return -1;
+	}
+
+	return 0;
+}
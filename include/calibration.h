@@ -18,7 +18,15 @@
 #ifndef _CALIBRATION_H_
 #define _CALIBRATION_H_
 
+#define CURVE_N 0x400 // number of lookup table segments
+
+#define TUNE_SMPR_N 8 // ADC sample times of 1.5, 2.5, 4.5, 7.5, 19.5, 61.5, 181.5 and 601.5 cycles
+#define TUNE_SETTLE_N 3 // mux settle delays of 8, 2 and 0 us
+#define TUNE_N (TUNE_SMPR_N*TUNE_SETTLE_N) // tested settings, most conservative first
+
 typedef struct _Calibration Calibration;
+typedef struct _Curve_Segment Curve_Segment;
+typedef struct _Tuning Tuning;
 
 struct _Calibration {
 	uint16_t qui [SENSOR_N]; // quiscent value
@@ -28,12 +36,29 @@ struct _Calibration {
 	float C [3];
 };
 
+struct _Tuning {
+	uint8_t smpr; // selected ADC sample time, index into the available sample times
+	uint8_t settle; // selected mux settle delay in us
+	uint16_t bound; // noise and crosstalk bound in 1/16 LSB
+	uint16_t noise [TUNE_N]; // worst per-sensor RMS noise of each tested setting in 1/16 LSB
+	uint16_t crosstalk [TUNE_N]; // worst per-sensor deviation from the most conservative setting in 1/16 LSB
+};
+
+struct _Curve_Segment {
+	float a; // intercept
+	float b; // slope
+};
+
 // globals
 extern Calibration range;
 extern uint_fast8_t zeroing;
 extern uint_fast8_t calibrating;
-extern float curve [0x800]; // lookup table for distance-magnetic-flux relationship
-extern const OSC_Query_Item calibration_tree [16];
+extern Curve_Segment curve [CURVE_N + 1]; // lookup table for distance-magnetic-flux relationship
+extern Tuning tune;
+extern uint_fast8_t tuning;
+extern uint8_t tune_smpr; // ADC sample time to acquire with
+extern uint8_t tune_settle; // mux settle delay to acquire with
+extern const OSC_Query_Item calibration_tree [17];
 
 uint_fast8_t range_load(uint_fast8_t pos);
 uint_fast8_t range_reset(void);
@@ -41,7 +66,19 @@ uint_fast8_t range_save(uint_fast8_t pos);
 
 void range_curve_update(void);
 
-void range_calibrate(int16_t *raw12, int16_t *raw3, uint8_t *order12, uint8_t *order3, int16_t *sum, int16_t *rela);
+// linear lookup interpolation as a single multiply-add, 0 <= y <= 1
+static inline __always_inline float
+curve_lookup(float y)
+{
+	const Curve_Segment *seg = &curve[(uint32_t)(y * CURVE_N)];
+	return seg->a + seg->b*y;
+}
+
+void range_calibrate(int16_t *rela);
 void range_init(void);
 
+uint_fast8_t tune_load(void);
+uint_fast8_t tune_save(void);
+void tune_process(int16_t *rela);
+
 #endif // _CALIBRATION_H_
@@ -86,9 +86,34 @@ extern const stm32_pin_info PIN_MAP [];
 #define ADC_BITDEPTH 0xfff
 #define ADC_HALF_BITDEPTH 0x7ff
 
-#define BLOB_MAX 8
+#ifndef BLOB_MAX
+#	define BLOB_MAX 8
+#endif
 
-#define CHIMAERA_BUFSIZE 0x500
+// output buffers grow with the maximal number of simultaneous blobs
+#if BLOB_MAX == 8
+#	define CHIMAERA_BUFSIZE 0x500
+#elif BLOB_MAX == 16
+#	define CHIMAERA_BUFSIZE 0x900
+#elif BLOB_MAX == 32
+#	define CHIMAERA_BUFSIZE 0x1100
+#else
+#	error "invalid maximal number of blobs given to Make(-DBLOB_MAX)" BLOB_MAX
+#endif
+
+// additional UDP destinations sharing the output socket, each takes another CHIMAERA_BUFSIZE of RAM
+#ifndef OUTPUT_FANOUT_MAX
+#	if BLOB_MAX == 32
+#		define OUTPUT_FANOUT_MAX 1
+#	else
+#		define OUTPUT_FANOUT_MAX 2
+#	endif
+#elif (OUTPUT_FANOUT_MAX < 0) || (OUTPUT_FANOUT_MAX > 2)
+#	error "invalid number of fan-out destinations given to Make(-DOUTPUT_FANOUT_MAX)" OUTPUT_FANOUT_MAX
+#endif
+
+#define FRAME_BUFSIZE 0x100 // OSC footprint of bundle headers, frame and alive messages
+#define BLOB_BUFSIZE 0x60 // OSC footprint of an updated blob in the most verbose engine (tuio1, tuio2 with derivatives)
 
 #define ADC_DMA_PRIORITY 0x2
 #define SPI_RX_DMA_PRIORITY 0x3
@@ -115,6 +140,7 @@ extern Reset_Mode reset_mode;
 #define EEPROM_RANGE_OFFSET 0x1000
 #define EEPROM_RANGE_SIZE 0x0510
 #define EEPROM_RANGE_MAX 2 // we have place for three slots: 0, 1, 2
+#define EEPROM_TUNE_OFFSET (EEPROM_RANGE_OFFSET + (EEPROM_RANGE_MAX+1)*EEPROM_RANGE_SIZE) // right behind the calibration slots
 
 // WIZnet interfacing
 #if REVISION == 3
@@ -187,6 +213,7 @@ extern const uint_fast8_t buf_i_ptr;
 
 extern uint8_t buf_o[2] [CHIMAERA_BUFSIZE]; // general purpose output buffer
 extern uint8_t buf_i[1] [CHIMAERA_BUFSIZE]; // general purpose input buffer
+extern uint8_t buf_f[OUTPUT_FANOUT_MAX] [CHIMAERA_BUFSIZE]; // fan-out output buffers
 
 #define BUF_O_BASE(ptr)(buf_o[ptr])
 #define BUF_I_BASE(ptr)(buf_i[ptr])
@@ -198,6 +225,10 @@ extern uint8_t buf_i[1] [CHIMAERA_BUFSIZE]; // general purpose input buffer
 //#define BUF_O_MAX(ptr)(buf_o[ptr] + CHIMAERA_BUFSIZE - 2*(WIZ_SEND_OFFSET-3)) // WIZ5200
 #define BUF_O_MAX(ptr)(buf_o[ptr] + CHIMAERA_BUFSIZE - (WIZ_SEND_OFFSET-3)) // WIZ5500
 
+#define BUF_F_BASE(d)(buf_f[d])
+#define BUF_F_OFFSET(d)(buf_f[d] + WIZ_SEND_OFFSET)
+#define BUF_F_MAX(d)(buf_f[d] + CHIMAERA_BUFSIZE - (WIZ_SEND_OFFSET-3)) // WIZ5500
+
 #define adc_timer TIMER1
 #define NVIC_ADC_TIMER	NVIC_TIMER1_CC
 
@@ -28,6 +28,8 @@ uint8_t subnet_to_cidr(uint8_t *subnet);
 void broadcast_address(uint8_t *brd, uint8_t *ip, uint8_t *subnet);
 
 void adc_timer_reconfigure(void);
+uint16_t adc_timer_rate(void);
+uint32_t adc_sweep_time(void);
 void sync_timer_reconfigure(void);
 void dhcpc_timer_reconfigure(void);
 void mdns_timer_reconfigure(void);
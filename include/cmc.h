@@ -21,7 +21,10 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <series/simd.h>
+
 #include <oscquery.h>
+#include <chimaera.h>
 
 #define CMC_NOSCALE 0.0f
 
@@ -31,18 +34,26 @@
 
 typedef struct _CMC_Engine CMC_Engine;
 typedef struct _CMC_Group CMC_Group;
+typedef struct _CMC_Output CMC_Output;
 typedef struct _CMC_Frame_Event CMC_Frame_Event;
 typedef struct _CMC_Blob_Event CMC_Blob_Event;
 
 typedef void (*CMC_Engine_Init_Cb)(void);
+typedef void (*CMC_Interpolation_Cb)(uint_fast8_t P, float *x, float *y);
 typedef osc_data_t *(*CMC_Engine_Frame_Cb)(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev);
 typedef osc_data_t *(*CMC_Engine_Blob_Cb)(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev);
+typedef osc_data_t *(*CMC_Flush_Cb)(osc_data_t *buf, osc_data_t **end);
 
 #ifdef BENCHMARK
 #	include <chimutil.h>
 extern Stop_Watch sw_engine_process;
 #endif
 
+#ifdef BENCHMARK_INTERPOLATION
+extern uint64_t cmc_interpolation_cycles;
+extern uint32_t cmc_interpolation_peaks;
+#endif
+
 struct _CMC_Engine {
 	CMC_Engine_Init_Cb init_cb;
 	CMC_Engine_Frame_Cb frame_cb;
@@ -65,6 +76,13 @@ struct _CMC_Frame_Event {
 	OSC_Timetag offset;
 	uint_fast8_t nblob_old;
 	uint_fast8_t nblob_new;
+	uint_fast8_t nested; // engine bundle shares its packet with others
+	uint_fast8_t split; // bundle boundary due to a packet split, not a frame boundary
+};
+
+struct _CMC_Output {
+	osc_data_t *ptr;
+	osc_data_t *end;
 };
 
 struct _CMC_Blob_Event {
@@ -76,16 +94,58 @@ struct _CMC_Blob_Event {
 	float m;
 };
 
+#define CMC_MASK_N ((SENSOR_N + 31) / 32)
+
+typedef struct _CMC_Mask CMC_Mask;
+
+struct _CMC_Mask {
+	uint32_t aoi [CMC_MASK_N]; // sensors above half threshold, MSB first
+	uint32_t north [CMC_MASK_N]; // sensors with north polarity, MSB first
+};
+
+static inline __always_inline void
+cmc_mask_clear(CMC_Mask *mask)
+{
+	uint_fast8_t w;
+	for(w=0; w<CMC_MASK_N; w++)
+	{
+		mask->aoi[w] = 0;
+		mask->north[w] = 0;
+	}
+}
+
+// packed test of sensors 2*i and 2*i+1: aval > thresh / 2 <=> (thresh - 2*val < 0) || (thresh + 2*val < 0)
+static inline __always_inline void
+cmc_mask_pair(CMC_Mask *mask, uint_fast8_t i, uint32_t rela32, uint32_t thresh32)
+{
+	uint32_t val2 = __sadd16(rela32, rela32); // 2*val
+	uint32_t sign = __ssub16(thresh32, val2) | __sadd16(thresh32, val2);
+	uint_fast8_t shift = 30 -((i & 0xf) << 1);
+
+	// gather sign bits of low and high halfword
+	mask->aoi[i >> 4] |= (((sign >> 14) & 0x2) | (sign >> 31)) << shift;
+	mask->north[i >> 4] |= (((rela32 >> 14) & 0x2) | (rela32 >> 31)) << shift;
+}
+
 extern CMC_Group *cmc_groups;
 extern uint16_t cmc_groups_n;
 extern uint_fast8_t cmc_engines_active;
+extern uint8_t cmc_dest_engines [OUTPUT_FANOUT_MAX+1]; // active engines per destination, 0: output socket
+extern CMC_Output cmc_fanout [OUTPUT_FANOUT_MAX];
+extern CMC_Flush_Cb cmc_flush_cb; // sends packet of output socket so far, returns fresh one
 
 void cmc_velocity_stiffness_update(uint8_t stiffness);
+void cmc_prediction_update(uint8_t enabled);
+uint_fast8_t cmc_idle_level(void);
+uint_fast8_t cmc_blob_sids(int32_t *sids);
+uint_fast8_t cmc_blob_peaks(uint8_t *peak);
+void cmc_interpolation_update(uint8_t mode);
 void cmc_init(void);
-osc_data_t *cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, osc_data_t *buf, osc_data_t *end);
+osc_data_t *cmc_process(OSC_Timetag now, OSC_Timetag offset, int16_t *rela, const CMC_Mask *mask, const float *stamp, osc_data_t *buf, osc_data_t *end);
 
 void cmc_group_reset(void);
 void cmc_group_update(void);
 void cmc_engines_update(void);
+void cmc_engines_resize(void);
 
 #endif // _CMC_H_
@@ -83,6 +83,7 @@ struct _Config {
 	 * read-only
 	 */
  	Firmware_Version version;
+	uint16_t size; // layout check, depends on build options too
 
 	/*
 	 * read-write
@@ -99,21 +100,33 @@ struct _Config {
 
 	struct _dump {
 		uint8_t enabled;
+		uint8_t encoding;
+		uint8_t decimation;
+		uint8_t window;
 	} dump;
 
 	struct _tuio2 {
 		uint8_t enabled;
 		uint8_t derivatives;
+		uint8_t deltas;
+		uint8_t decimation;
+		uint8_t destination; // 0: output socket, n: output fanout n-1
 	} tuio2;
 
 	struct _tuio1 {
 		uint8_t enabled;
 		uint8_t custom_profile;
+		uint8_t deltas;
+		uint8_t decimation;
+		uint8_t destination; // 0: output socket, n: output fanout n-1
 	} tuio1;
 
 	struct _scsynth {
 		uint8_t enabled;
 		uint8_t derivatives;
+		uint8_t deltas;
+		uint8_t decimation;
+		uint8_t destination; // 0: output socket, n: output fanout n-1
 	} scsynth;
 
 	struct _oscmidi {
@@ -121,6 +134,9 @@ struct _Config {
 		uint8_t multi;
 		uint8_t format;
 		uint8_t mpe;
+		uint8_t deltas;
+		uint8_t decimation;
+		uint8_t destination; // 0: output socket, n: output fanout n-1
 		char path [64];
 	} oscmidi;
 
@@ -128,10 +144,16 @@ struct _Config {
 		uint8_t enabled;
 		uint8_t redundancy;
 		uint8_t derivatives;
+		uint8_t deltas;
+		uint8_t decimation;
+		uint8_t destination; // 0: output socket, n: output fanout n-1
 	} dummy;
 
 	struct _custom {
 		uint8_t enabled;
+		uint8_t deltas;
+		uint8_t decimation;
+		uint8_t destination; // 0: output socket, n: output fanout n-1
 		Custom_Item items [CUSTOM_MAX_EXPR];
 	} custom;
 
@@ -143,6 +165,9 @@ struct _Config {
 			uint8_t z;
 		} invert;
 		uint8_t parallel;
+		uint16_t keepalive; // frames between full updates in deltas mode, 0 disables
+		float tolerance; // movement below which blobs count as still in deltas mode
+		Socket_Config fanout [OUTPUT_FANOUT_MAX]; // UDP only, sent through SOCK_OUTPUT
 	} output;
 
 	struct _config {
@@ -180,10 +205,26 @@ struct _Config {
 	} dhcpc;
 
 	struct _sensors {
-		uint8_t movingaverage_bitshift;
+		uint16_t smoothing; // Q15 coefficient of the first-order IIR sensor filter, 0 disables it
 		uint8_t interpolation_mode;
 		uint8_t velocity_stiffness;
+		uint8_t prediction;
+		uint8_t pipelined;
+		uint8_t oversampling; // conversions per sensor and mux step, averaged in hardware time
+		struct {
+			uint8_t enabled;
+			uint8_t interval; // frames per full sweep, the others only cover areas of interest
+		} roi;
 		uint16_t rate; // the maximal update rate the chimaera should run at
+		struct {
+			uint8_t enabled;
+			uint16_t min; // the minimal update rate when idle
+		} governor;
+		struct {
+			uint8_t enabled;
+			uint8_t feed; // raise thresholds above the measured noise floor
+			uint16_t bound; // RMS noise in 1/16 LSB above which a sensor is flagged as noisy
+		} health;
 	} sensors;
 
 	CMC_Group groups [GROUP_MAX];
@@ -214,6 +255,8 @@ uint_fast8_t config_check_bool(const char *path, const char *fmt, uint_fast8_t a
 uint_fast8_t config_check_float(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, float *val);
 
 extern const OSC_Query_Argument config_boolean_args [1];
+extern const OSC_Query_Argument config_decimation_args [1];
+extern const OSC_Query_Argument config_destination_args [1];
 extern const OSC_Query_Argument config_mode_args [1];
 extern const OSC_Query_Argument config_address_args [1];
 
@@ -39,6 +39,7 @@ typedef uint8_t osc_data_t;
 typedef fix_32_32_t OSC_Timetag;
 typedef struct _OSC_Blob OSC_Blob;
 typedef struct _OSC_Method OSC_Method;
+typedef struct _OSC_Template OSC_Template;
 
 typedef uint_fast8_t (*OSC_Method_Cb)(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *arg);
 
@@ -99,6 +100,14 @@ struct _OSC_Method {
  */
 
 #define OSC_IMMEDIATE	(1ULLK >> 32)
+#define OSC_TEMPLATE_MAX 72 // path (<64) + format + constant leading arguments
+
+// pre-serialized message head (padded path, format and constant leading arguments)
+struct _OSC_Template {
+	uint16_t head; // length of the cached image
+	uint16_t size; // head + fixed-size arguments
+	osc_data_t image [OSC_TEMPLATE_MAX];
+};
 
 /*
  * Methods
@@ -155,6 +164,39 @@ osc_blobsize(osc_data_t *buf)
 	return s.i;
 }
 
+// copy cached message head, checks space for all fixed-size arguments at once
+inline osc_data_t *
+osc_set_template(osc_data_t *buf, osc_data_t *end, const OSC_Template *tmpl)
+{
+	if(!buf || (buf + tmpl->size > end) )
+		return NULL;
+	memcpy(buf, tmpl->image, tmpl->head);
+	return buf + tmpl->head;
+}
+
+// unchecked argument writers, only valid after osc_set_template
+inline osc_data_t *
+osc_put_int32(osc_data_t *buf, int32_t i)
+{
+	if(!buf)
+		return NULL;
+	swap32_t *s = (swap32_t *)buf;
+	s->i = i;
+	s->u = htonl(s->u);
+	return buf + 4;
+}
+
+inline osc_data_t *
+osc_put_float(osc_data_t *buf, float f)
+{
+	if(!buf)
+		return NULL;
+	swap32_t *s = (swap32_t *)buf;
+	s->f = f;
+	s->u = htonl(s->u);
+	return buf + 4;
+}
+
 _Pragma("GCC diagnostic pop")
 
 osc_data_t *osc_get_path(osc_data_t *buf, const char **path);
@@ -185,6 +227,10 @@ osc_data_t *osc_set_char(osc_data_t *buf, osc_data_t *end, char c);
 osc_data_t *osc_set_midi(osc_data_t *buf, osc_data_t *end, uint8_t *m);
 osc_data_t *osc_set_midi_inline(osc_data_t *buf, osc_data_t *end, uint8_t **m);
 
+// create template
+int osc_template_init(OSC_Template *tmpl, const char *path, const char *fmt);
+int osc_template_string(OSC_Template *tmpl, const char *s);
+
 // create bundle
 osc_data_t *osc_start_bundle(osc_data_t *buf, osc_data_t *end, OSC_Timetag timetag, osc_data_t **bndl);
 osc_data_t *osc_end_bundle(osc_data_t *buf, osc_data_t *end, osc_data_t *bndl);
@@ -20,13 +20,24 @@
 
 #include <chimaera.h>
 #include <oscquery.h>
+#include <cmc.h>
+
+#define HEALTH_STRIDE 4 // sensors updated per frame
+#define HEALTH_WARMUP 64 // samples per sensor before it is judged
+#define HEALTH_FEED_SIGMA 5 // thresholds fed by the noise floor are at least this many RMS deviations
+
+enum Health_Flag {
+	HEALTH_STUCK			= (1 << 0), // no noise at all
+	HEALTH_SATURATED	= (1 << 1), // at ADC rail
+	HEALTH_NOISY			= (1 << 2) // RMS noise above bound
+};
 
 extern uint8_t adc1_sequence [ADC_DUAL_LENGTH]; // analog input pins read out by the ADC1
 extern uint8_t adc2_sequence [ADC_DUAL_LENGTH]; // analog input pins read out by the ADC2
 extern uint8_t adc3_sequence [ADC_SING_LENGTH]; // analog input pins read out by the ADC3
 extern uint8_t adc_unused [ADC_UNUSED_LENGTH];
 extern uint8_t adc_order [ADC_LENGTH];
-extern const OSC_Query_Item sensors_tree [6];
+extern const OSC_Query_Item sensors_tree [14];
 
 enum Interpolation_Mode {
 	INTERPOLATION_NONE,
@@ -35,4 +46,8 @@ enum Interpolation_Mode {
 	INTERPOLATION_LAGRANGE
 };
 
+void sensors_health_reset(void);
+void sensors_health_restore(void);
+void sensors_health_update(const int16_t *rela, const CMC_Mask *mask);
+
 #endif // _SENSORS_H_
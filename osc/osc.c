@@ -259,6 +259,11 @@ extern inline size_t osc_fmtlen(const char *buf);
 extern inline size_t osc_bloblen(osc_data_t *buf);
 extern inline size_t osc_blobsize(osc_data_t *buf);
 
+// templates
+extern inline osc_data_t *osc_set_template(osc_data_t *buf, osc_data_t *end, const OSC_Template *tmpl);
+extern inline osc_data_t *osc_put_int32(osc_data_t *buf, int32_t i);
+extern inline osc_data_t *osc_put_float(osc_data_t *buf, float f);
+
 // get OSC arguments from raw buffer
 osc_data_t *
 osc_get_path(osc_data_t *buf, const char **path)
@@ -519,6 +524,64 @@ osc_set_midi_inline(osc_data_t *buf, osc_data_t *end, uint8_t **m)
 	return buf + 4;
 }
 
+// create template
+int
+osc_template_init(OSC_Template *tmpl, const char *path, const char *fmt)
+{
+	osc_data_t *end = tmpl->image + OSC_TEMPLATE_MAX;
+	osc_data_t *buf_ptr = tmpl->image;
+
+	buf_ptr = osc_set_path(buf_ptr, end, path);
+	buf_ptr = osc_set_fmt(buf_ptr, end, fmt);
+	if(!buf_ptr)
+	{
+		tmpl->head = 0;
+		tmpl->size = 0;
+		return 0;
+	}
+
+	tmpl->head = buf_ptr - tmpl->image;
+	tmpl->size = tmpl->head;
+
+	// reserve space for fixed-size arguments, variable-size ones stay checked
+	const char *type;
+	for(type=fmt; *type!='\0'; type++)
+		switch((OSC_Type)*type)
+		{
+			case OSC_INT32:
+			case OSC_FLOAT:
+			case OSC_CHAR:
+			case OSC_MIDI:
+				tmpl->size += 4;
+				break;
+			case OSC_INT64:
+			case OSC_DOUBLE:
+			case OSC_TIMETAG:
+				tmpl->size += 8;
+				break;
+			default:
+				break;
+		}
+
+	return 1;
+}
+
+// append constant leading string argument to template head (e.g. TUIO 'set')
+int
+osc_template_string(OSC_Template *tmpl, const char *s)
+{
+	osc_data_t *end = tmpl->image + OSC_TEMPLATE_MAX;
+	osc_data_t *buf_ptr = osc_set_string(tmpl->image + tmpl->head, end, s);
+	if(!buf_ptr)
+		return 0;
+
+	size_t len = buf_ptr - (tmpl->image + tmpl->head);
+	tmpl->head += len;
+	tmpl->size += len;
+
+	return 1;
+}
+
 // create bundle
 osc_data_t * __CCM_TEXT__
 osc_start_bundle(osc_data_t *buf, osc_data_t *end, OSC_Timetag timetag, osc_data_t **bndl)
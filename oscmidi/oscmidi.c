@@ -48,6 +48,9 @@ static const char *oscmidi_fmt_1 [] = {
 	[OSC_MIDI_FORMAT_BLOB] = "b"
 };
 
+// cached message heads for 1..4 arguments in current path and format
+static OSC_Template oscmidi_tmpl [4];
+
 static MIDI_Hash oscmidi_hash [BLOB_MAX];
 static mpe_t mpe;
 
@@ -56,6 +59,17 @@ static osc_data_t *bndl;
 
 static uint_fast8_t update_zones = 0;
 
+static void
+oscmidi_template_update(void)
+{
+	OSC_MIDI_Format format = config.oscmidi.format;
+
+	osc_template_init(&oscmidi_tmpl[0], config.oscmidi.path, oscmidi_fmt_1[format]);
+	osc_template_init(&oscmidi_tmpl[1], config.oscmidi.path, oscmidi_fmt_2[format]);
+	osc_template_init(&oscmidi_tmpl[2], config.oscmidi.path, oscmidi_fmt_3[format]);
+	osc_template_init(&oscmidi_tmpl[3], config.oscmidi.path, oscmidi_fmt_4[format]);
+}
+
 static void
 oscmidi_init(void)
 {
@@ -69,6 +83,8 @@ oscmidi_init(void)
 			mul[i] = (float)0x1fff / group->range;
 	}
 
+	oscmidi_template_update();
+
 	// populate mpe struct
 	mpe_populate(&mpe, cmc_groups_n);
 
@@ -86,8 +102,7 @@ oscmidi_serialize(osc_data_t *buf, osc_data_t *end, OSC_MIDI_Format format, uint
 	if(!multi)
 	{
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
-		buf_ptr = osc_set_path(buf_ptr, end, config.oscmidi.path);
-		buf_ptr = osc_set_fmt(buf_ptr, end, oscmidi_fmt_1[format]);
+		buf_ptr = osc_set_template(buf_ptr, end, &oscmidi_tmpl[0]);
 	}
 
 	switch(format)
@@ -136,7 +151,7 @@ oscmidi_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
 	osc_data_t *buf_ptr = buf;
 
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &pack);
 	buf_ptr = osc_start_bundle(buf_ptr, end, fev->offset, &bndl);
 
@@ -181,11 +196,10 @@ oscmidi_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 static osc_data_t *
 oscmidi_engine_end_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
-	(void)fev;
 	osc_data_t *buf_ptr = buf;
 
 	buf_ptr = osc_end_bundle(buf_ptr, end, bndl);
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_end_bundle_item(buf_ptr, end, pack);
 
 	return buf_ptr;
@@ -205,11 +219,10 @@ oscmidi_engine_on_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 	if(multi)
 	{
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
-		buf_ptr = osc_set_path(buf_ptr, end, config.oscmidi.path);
 		if( (mapping == OSC_MIDI_MAPPING_CONTROL_CHANGE) && (group->control <= 0xd) )
-			buf_ptr = osc_set_fmt(buf_ptr, end, oscmidi_fmt_4[format]);
+			buf_ptr = osc_set_template(buf_ptr, end, &oscmidi_tmpl[3]);
 		else
-			buf_ptr = osc_set_fmt(buf_ptr, end, oscmidi_fmt_3[format]);
+			buf_ptr = osc_set_template(buf_ptr, end, &oscmidi_tmpl[2]);
 	}
 
 	uint8_t ch;
@@ -260,8 +273,7 @@ oscmidi_engine_off_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 	if(multi)
 	{
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
-		buf_ptr = osc_set_path(buf_ptr, end, config.oscmidi.path);
-		buf_ptr = osc_set_fmt(buf_ptr, end, oscmidi_fmt_1[format]);
+		buf_ptr = osc_set_template(buf_ptr, end, &oscmidi_tmpl[0]);
 	}
 
 	uint8_t key;
@@ -292,11 +304,10 @@ oscmidi_engine_set_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 	if(multi)
 	{
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
-		buf_ptr = osc_set_path(buf_ptr, end, config.oscmidi.path);
 		if( (mapping == OSC_MIDI_MAPPING_CONTROL_CHANGE) && (group->control <= 0xd) )
-			buf_ptr = osc_set_fmt(buf_ptr, end, oscmidi_fmt_3[format]);
+			buf_ptr = osc_set_template(buf_ptr, end, &oscmidi_tmpl[2]);
 		else
-			buf_ptr = osc_set_fmt(buf_ptr, end, oscmidi_fmt_2[format]);
+			buf_ptr = osc_set_template(buf_ptr, end, &oscmidi_tmpl[1]);
 	}
 
 	float X = group->offset + bev->x*group->range;
@@ -350,10 +361,32 @@ _oscmidi_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_
 	return res;
 }
 
+static uint_fast8_t
+_oscmidi_deltas(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.oscmidi.deltas);
+}
+
+static uint_fast8_t
+_oscmidi_decimation(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint8(path, fmt, argc, buf, &config.oscmidi.decimation);
+}
+
+static uint_fast8_t
+_oscmidi_destination(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.oscmidi.destination);
+	cmc_engines_update();
+	return res;
+}
+
 static uint_fast8_t
 _oscmidi_multi(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
-	return config_check_bool(path, fmt, argc, buf, &config.oscmidi.multi);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.oscmidi.multi);
+	cmc_engines_resize();
+	return res;
 }
 
 static uint_fast8_t
@@ -362,6 +395,7 @@ _oscmidi_mpe(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *b
 	uint8_t res = config_check_bool(path, fmt, argc, buf, &config.oscmidi.mpe);
 	if( (argc > 1) && config.oscmidi.mpe)
 		oscmidi_init(); // send zones
+	cmc_engines_resize();
 	return res;
 }
 
@@ -386,6 +420,7 @@ _oscmidi_path(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *
 		if(osc_check_path(opath))
 		{
 			strcpy(config.oscmidi.path, opath);
+			oscmidi_template_update();
 			size = CONFIG_SUCCESS("is", uuid, path);
 		}
 		else
@@ -394,6 +429,7 @@ _oscmidi_path(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *
 
 	CONFIG_SEND(size);
 
+	cmc_engines_resize();
 	return 1;
 }
 
@@ -425,6 +461,7 @@ _oscmidi_format(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t
 			if(!strcmp(s, oscmidi_format_args_values[i].s))
 			{
 				*format = i;
+				oscmidi_template_update();
 				break;
 			}
 		size = CONFIG_SUCCESS("is", uuid, path);
@@ -432,6 +469,7 @@ _oscmidi_format(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t
 
 	CONFIG_SEND(size);
 
+	cmc_engines_resize();
 	return 1;
 }
 
@@ -468,6 +506,7 @@ _oscmidi_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t
 	if(config.oscmidi.mpe)
 		oscmidi_init(); // send zones
 
+	cmc_engines_resize();
 	return 1;
 }
 
@@ -519,6 +558,7 @@ _oscmidi_mapping(const char *path, const char *fmt, uint_fast8_t argc, osc_data_
 
 	CONFIG_SEND(size);
 
+	cmc_engines_resize();
 	return 1;
 }
 
@@ -548,7 +588,9 @@ _oscmidi_controller(const char *path, const char *fmt, uint_fast8_t argc, osc_da
 {
 	OSC_MIDI_Group *grp = OSCMIDI_GID(path);
 
-	return config_check_uint8(path, fmt, argc, buf, &grp->control);
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &grp->control);
+	cmc_engines_resize();
+	return res;
 }
 
 /*
@@ -592,6 +634,9 @@ static const OSC_Query_Item group_array [] = {
 
 const OSC_Query_Item oscmidi_tree [] = {
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _oscmidi_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("deltas", "Only send changed blobs", _oscmidi_deltas, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("decimation", "Update blobs every Nth frame", _oscmidi_decimation, config_decimation_args),
+	OSC_QUERY_ITEM_METHOD("destination", "Output destination", _oscmidi_destination, config_destination_args),
 	OSC_QUERY_ITEM_METHOD("multi", "OSC Multi argument?", _oscmidi_multi, config_boolean_args),
 	OSC_QUERY_ITEM_METHOD("format", "OSC Format", _oscmidi_format, oscmidi_format_args),
 	OSC_QUERY_ITEM_METHOD("mpe", "Multidimensional polyphonic expression?", _oscmidi_mpe, config_boolean_args),
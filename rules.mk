@@ -74,11 +74,15 @@ endif
 # custom preprocessor flags
 #CFLAGS_$(d) += -DBENCHMARK
 CFLAGS_$(d) += -DSENSOR_N=$(SENSORS)
+CFLAGS_$(d) += -DBLOB_MAX=$(BLOBS)
 CFLAGS_$(d) += -DWIZ_CHIP=$(WIZ_CHIP)
 CFLAGS_$(d) += -DREVISION=$(REVISION)
 CFLAGS_$(d) += -DVERSION_MAJOR=$(VERSION_MAJOR)
 CFLAGS_$(d) += -DVERSION_MINOR=$(VERSION_MINOR)
 CFLAGS_$(d) += -DVERSION_PATCH=$(VERSION_PATCH)
+ifneq ($(FANOUT),)
+CFLAGS_$(d) += -DOUTPUT_FANOUT_MAX=$(FANOUT)
+endif
 
 # CXXFLAGS_$(d) are extra flags passed to the C++ compiler. We'll need
 # our include directory, and we'll also add an extra definition as a
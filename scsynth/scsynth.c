@@ -48,6 +48,8 @@ static const char *set_fmt [2] = {
 
 static const char *default_fmt = "synth_%i";
 
+static OSC_Template set_tmpl [2];
+
 static OSC_Timetag tt;
 
 static uint_fast8_t early_i = 0;
@@ -56,6 +58,13 @@ static uint_fast8_t late_i = 0;
 static osc_data_t *pack;
 static osc_data_t *bndl;
 
+static void
+scsynth_init(void)
+{
+	osc_template_init(&set_tmpl[0], set_str, set_fmt[0]);
+	osc_template_init(&set_tmpl[1], set_str, set_fmt[1]);
+}
+
 static osc_data_t *
 scsynth_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
@@ -65,7 +74,7 @@ scsynth_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 
 	osc_data_t *buf_ptr = buf;
 
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &pack);
 	buf_ptr = osc_start_bundle(buf_ptr, end, fev->offset, &bndl);
 
@@ -75,11 +84,10 @@ scsynth_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 static osc_data_t *
 scsynth_engine_end_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
-	(void)fev;
 	osc_data_t *buf_ptr = buf;
 
 	buf_ptr = osc_end_bundle(buf_ptr, end, bndl);
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_end_bundle_item(buf_ptr, end, pack);
 
 	return buf_ptr;
@@ -138,18 +146,17 @@ scsynth_engine_on_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 	// first set message
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, set_str);
-		buf_ptr = osc_set_fmt(buf_ptr, end, set_fmt[config.scsynth.derivatives]);
-
-		buf_ptr = osc_set_int32(buf_ptr, end, id);
-		buf_ptr = osc_set_int32(buf_ptr, end, group->arg + 0);
-		buf_ptr = osc_set_int32(buf_ptr, end, config.scsynth.derivatives ? 4 : 2);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->x);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->y);
+		buf_ptr = osc_set_template(buf_ptr, end, &set_tmpl[config.scsynth.derivatives]);
+
+		buf_ptr = osc_put_int32(buf_ptr, id);
+		buf_ptr = osc_put_int32(buf_ptr, group->arg + 0);
+		buf_ptr = osc_put_int32(buf_ptr, config.scsynth.derivatives ? 4 : 2);
+		buf_ptr = osc_put_float(buf_ptr, bev->x);
+		buf_ptr = osc_put_float(buf_ptr, bev->y);
 		if(config.scsynth.derivatives)
 		{
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vx);
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vy);
+			buf_ptr = osc_put_float(buf_ptr, bev->vx);
+			buf_ptr = osc_put_float(buf_ptr, bev->vy);
 		}
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
@@ -198,18 +205,17 @@ scsynth_engine_set_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, set_str);
-		buf_ptr = osc_set_fmt(buf_ptr, end, set_fmt[config.scsynth.derivatives]);
-
-		buf_ptr = osc_set_int32(buf_ptr, end, id);
-		buf_ptr = osc_set_int32(buf_ptr, end, group->arg + 0);
-		buf_ptr = osc_set_int32(buf_ptr, end, config.scsynth.derivatives ? 4 : 2);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->x);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->y);
+		buf_ptr = osc_set_template(buf_ptr, end, &set_tmpl[config.scsynth.derivatives]);
+
+		buf_ptr = osc_put_int32(buf_ptr, id);
+		buf_ptr = osc_put_int32(buf_ptr, group->arg + 0);
+		buf_ptr = osc_put_int32(buf_ptr, config.scsynth.derivatives ? 4 : 2);
+		buf_ptr = osc_put_float(buf_ptr, bev->x);
+		buf_ptr = osc_put_float(buf_ptr, bev->y);
 		if(config.scsynth.derivatives)
 		{
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vx);
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vy);
+			buf_ptr = osc_put_float(buf_ptr, bev->vx);
+			buf_ptr = osc_put_float(buf_ptr, bev->vy);
 		}
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
@@ -218,7 +224,7 @@ scsynth_engine_set_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 }
 
 CMC_Engine scsynth_engine = {
-	NULL,
+	scsynth_init,
 	scsynth_engine_frame_cb,
 	scsynth_engine_on_cb,
 	scsynth_engine_off_cb,
@@ -238,10 +244,32 @@ _scsynth_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_
 	return res;
 }
 
+static uint_fast8_t
+_scsynth_deltas(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.scsynth.deltas);
+}
+
+static uint_fast8_t
+_scsynth_decimation(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint8(path, fmt, argc, buf, &config.scsynth.decimation);
+}
+
+static uint_fast8_t
+_scsynth_destination(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.scsynth.destination);
+	cmc_engines_update();
+	return res;
+}
+
 static uint_fast8_t
 _scsynth_derivatives(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
-	return config_check_bool(path, fmt, argc, buf, &config.scsynth.derivatives);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.scsynth.derivatives);
+	cmc_engines_resize();
+	return res;
 }
 
 static uint_fast8_t
@@ -273,6 +301,7 @@ _scsynth_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t
 	size = CONFIG_SUCCESS("is", uuid, path);
 	CONFIG_SEND(size);
 
+	cmc_engines_resize();
 	return 1;
 }
 
@@ -310,6 +339,7 @@ _scsynth_name(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *
 
 	CONFIG_SEND(size);
 
+	cmc_engines_resize();
 	return 1;
 }
 
@@ -350,7 +380,9 @@ _scsynth_allocate(const char *path, const char *fmt, uint_fast8_t argc, osc_data
 {
 	SCSynth_Group *grp = SCSYNTH_GID(path);
 
-	return config_check_bool(path, fmt, argc, buf, &grp->alloc);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &grp->alloc);
+	cmc_engines_resize();
+	return res;
 }
 
 static uint_fast8_t
@@ -358,7 +390,9 @@ _scsynth_gate(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *
 {
 	SCSynth_Group *grp = SCSYNTH_GID(path);
 
-	return config_check_bool(path, fmt, argc, buf, &grp->gate);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &grp->gate);
+	cmc_engines_resize();
+	return res;
 }
 
 static uint_fast8_t
@@ -419,6 +453,9 @@ static const OSC_Query_Item group_array [] = {
 
 const OSC_Query_Item scsynth_tree [] = {
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _scsynth_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("deltas", "Only send changed blobs", _scsynth_deltas, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("decimation", "Update blobs every Nth frame", _scsynth_decimation, config_decimation_args),
+	OSC_QUERY_ITEM_METHOD("destination", "Output destination", _scsynth_destination, config_destination_args),
 	OSC_QUERY_ITEM_METHOD("derivatives", "Calculate derivatives", _scsynth_derivatives, config_boolean_args),
 	OSC_QUERY_ITEM_METHOD("reset", "Reset attributes", _scsynth_reset, NULL),
 	OSC_QUERY_ITEM_ARRAY("attributes/", "Attributes", group_array, GROUP_MAX)
@@ -16,11 +16,14 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 #include <sensors.h>
 #include <config.h>
 #include <chimutil.h>
 #include <cmc.h>
+#include <calibration.h>
 
 #if SENSOR_N == 16
 uint8_t adc1_sequence [ADC_DUAL_LENGTH] = {}; // analog input pins read out by the ADC1
@@ -84,6 +87,107 @@ uint8_t adc_unused [ADC_UNUSED_LENGTH] = {};
 uint8_t adc_order [ADC_LENGTH] = { 9, 5, 8, 4, 7, 3, 6, 2, 1, 0};
 #endif
 
+/*
+ * Health
+ */
+
+#define HEALTH_ALPHA (1.f / 64) // weight of new samples in exponentially weighted mean and variance
+#define HEALTH_STUCK_VAR (1.f / 1024) // variance in LSB^2 below which a sensor is considered stuck
+
+static float health_mean [SENSOR_N]; // exponentially weighted mean of idle sensor values
+static float health_var [SENSOR_N]; // ^variance in LSB^2
+static uint8_t health_n [SENSOR_N]; // samples taken, saturating at HEALTH_WARMUP
+static uint8_t health_flags [SENSOR_N];
+static uint16_t health_calib [SENSOR_N]; // calibrated thresholds, the fed ones are derived from
+static uint16_t health_fed [SENSOR_N]; // ^thresholds as last written, to notice recalibration
+static uint_fast8_t health_pos = 0; // next sensor to update
+
+// put back calibrated thresholds, unless they have been replaced since they were fed
+void
+sensors_health_restore(void)
+{
+	uint_fast8_t pos;
+
+	for(pos=0; pos<SENSOR_N; pos++)
+	{
+		if(range.thresh[pos] == health_fed[pos])
+			range.thresh[pos] = health_calib[pos];
+		health_calib[pos] = health_fed[pos] = range.thresh[pos];
+	}
+}
+
+void
+sensors_health_reset(void)
+{
+	sensors_health_restore();
+	memset(health_mean, 0, sizeof(health_mean));
+	memset(health_var, 0, sizeof(health_var));
+	memset(health_n, 0, sizeof(health_n));
+	memset(health_flags, 0, sizeof(health_flags));
+	health_pos = 0;
+}
+
+// update statistics of a few sensors per frame only, to keep the cost out of the frame budget
+void
+sensors_health_update(const int16_t *rela, const CMC_Mask *mask)
+{
+	float bound2 = config.sensors.health.bound * (1.f / 16);
+	bound2 *= bound2;
+
+	uint_fast8_t k;
+	for(k=0; k<HEALTH_STRIDE; k++)
+	{
+		uint_fast8_t pos = health_pos;
+		int32_t raw = rela[pos] + range.qui[pos];
+		uint8_t flags = health_flags[pos] & ~HEALTH_SATURATED;
+
+		if( (raw <= 0) || (raw >= 0xfff) )
+			flags |= HEALTH_SATURATED;
+
+		if(!(mask->aoi[pos >> 5] & (0x80000000UL >> (pos & 0x1f)))) // only sample sensors below threshold
+		{
+			float d = rela[pos] - health_mean[pos];
+
+			if(health_n[pos] == 0) // first sample
+				health_mean[pos] = rela[pos];
+			else
+			{
+				health_mean[pos] += HEALTH_ALPHA * d;
+				health_var[pos] = (1.f - HEALTH_ALPHA) * (health_var[pos] + HEALTH_ALPHA * d*d);
+			}
+
+			if(health_n[pos] < HEALTH_WARMUP)
+				health_n[pos]++;
+			else
+			{
+				flags &= ~(HEALTH_STUCK | HEALTH_NOISY);
+				if(health_var[pos] < HEALTH_STUCK_VAR)
+					flags |= HEALTH_STUCK;
+				else if(health_var[pos] > bound2)
+					flags |= HEALTH_NOISY;
+			}
+		}
+
+		uint16_t thresh = range.thresh[pos];
+		if(thresh != health_fed[pos]) // recalibrated or loaded in the meantime
+			health_calib[pos] = thresh;
+		thresh = health_calib[pos];
+
+		if(config.sensors.health.feed && (health_n[pos] >= HEALTH_WARMUP) )
+		{
+			uint16_t floor = HEALTH_FEED_SIGMA * sqrtf(health_var[pos]) + 0.5f;
+			if(thresh < floor)
+				thresh = floor;
+		}
+
+		range.thresh[pos] = health_fed[pos] = thresh;
+		health_flags[pos] = flags;
+
+		if(++health_pos >= SENSOR_N)
+			health_pos = 0;
+	}
+}
+
 /*
  * Config
  */
@@ -154,11 +258,12 @@ _sensors_movingaverage(const char *path, const char *fmt, uint_fast8_t argc, osc
 	osc_data_t *buf_ptr = buf;
 	uint16_t size;
 	int32_t uuid;
+	uint16_t *smoothing = &config.sensors.smoothing;
 
 	buf_ptr = osc_get_int32(buf_ptr, &uuid);
 
-	if(argc == 1) // query
-		size = CONFIG_SUCCESS("isi", uuid, path, 1U << config.sensors.movingaverage_bitshift);
+	if(argc == 1) // query, window of the equivalent exponential moving average
+		size = CONFIG_SUCCESS("isi", uuid, path, *smoothing ? (0x8000 + *smoothing/2) / *smoothing : 1);
 	else
 	{
 		int32_t i;
@@ -166,19 +271,13 @@ _sensors_movingaverage(const char *path, const char *fmt, uint_fast8_t argc, osc
 		switch(i)
 		{
 			case 1:
-				config.sensors.movingaverage_bitshift = 0;
+				*smoothing = 0;
 				size = CONFIG_SUCCESS("is", uuid, path);
 				break;
 			case 2:
-				config.sensors.movingaverage_bitshift = 1;
-				size = CONFIG_SUCCESS("is", uuid, path);
-				break;
 			case 4:
-				config.sensors.movingaverage_bitshift = 2;
-				size = CONFIG_SUCCESS("is", uuid, path);
-				break;
 			case 8:
-				config.sensors.movingaverage_bitshift = 3;
+				*smoothing = 0x8000 / i;
 				size = CONFIG_SUCCESS("is", uuid, path);
 				break;
 			default:
@@ -191,6 +290,37 @@ _sensors_movingaverage(const char *path, const char *fmt, uint_fast8_t argc, osc
 	return 1;
 }
 
+static uint_fast8_t
+_sensors_smoothing(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+	uint16_t *smoothing = &config.sensors.smoothing;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isf", uuid, path, *smoothing / (float)0x8000);
+	else
+	{
+		float f;
+		buf_ptr = osc_get_float(buf_ptr, &f);
+		if( (f >= 0.f) && (f < 1.f) ) // 0 disables the filter, values close to 1 barely smooth
+		{
+			*smoothing = f * 0x8000;
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "valid coefficients are in [0, 1)");
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
 static uint_fast8_t
 _sensors_interpolation(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
@@ -215,6 +345,7 @@ _sensors_interpolation(const char *path, const char *fmt, uint_fast8_t argc, osc
 				*interpolation = i;
 				break;
 			}
+		cmc_interpolation_update(*interpolation);
 		size = CONFIG_SUCCESS("is", uuid, path);
 	}
 
@@ -231,6 +362,244 @@ _sensors_velocity_stiffness(const char *path, const char *fmt, uint_fast8_t argc
 	return res;
 }
 
+static uint_fast8_t
+_governor_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.sensors.governor.enabled);
+
+	if(!config.sensors.governor.enabled && config.sensors.rate) // return to full rate
+	{
+		timer_pause(adc_timer);
+		adc_timer_reconfigure();
+		timer_resume(adc_timer);
+	}
+
+	return res;
+}
+
+static uint_fast8_t
+_governor_min(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint16(path, fmt, argc, buf, &config.sensors.governor.min);
+}
+
+static uint_fast8_t
+_governor_effective(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	size = CONFIG_SUCCESS("isi", uuid, path, config.sensors.rate ? adc_timer_rate() : 0);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_sensors_oversampling(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isi", uuid, path, config.sensors.oversampling);
+	else
+	{
+		int32_t i;
+		buf_ptr = osc_get_int32(buf_ptr, &i);
+		switch(i)
+		{
+			case 1:
+			case 2:
+			case 4:
+				config.sensors.oversampling = i; // applied by loop while ADCs and DMA are idle
+				size = CONFIG_SUCCESS("is", uuid, path);
+				break;
+			default:
+				size = CONFIG_FAIL("iss", uuid, path, "valid oversampling factors are 1, 2 and 4");
+		}
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_sensors_sweep(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	size = CONFIG_SUCCESS("isi", uuid, path, adc_sweep_time());
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_roi_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.sensors.roi.enabled); // applied by loop while DMA is idle
+}
+
+static uint_fast8_t
+_roi_interval(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint8(path, fmt, argc, buf, &config.sensors.roi.interval);
+}
+
+static uint_fast8_t
+_health_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.sensors.health.enabled);
+	sensors_health_reset();
+	return res;
+}
+
+static uint_fast8_t
+_health_feed(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.sensors.health.feed);
+}
+
+static uint_fast8_t
+_health_bound(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isf", uuid, path, config.sensors.health.bound / 16.f);
+	else
+	{
+		float f;
+		buf_ptr = osc_get_float(buf_ptr, &f);
+		if( (f > 0.f) && (f < 0x1000) )
+		{
+			config.sensors.health.bound = f * 16.f;
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "valid bounds are in (0, 4096) LSB");
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+// get per-sensor RMS noise in 1/16 LSB
+static uint_fast8_t
+_health_noise(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	uint8_t *noise = NULL;
+	size = CONFIG_SUCCESS("isB", uuid, path, SENSOR_N, &noise);
+	uint_fast8_t i;
+	for(i=0; i<SENSOR_N; i++)
+	{
+		float rms = sqrtf(health_var[i]) * 16.f + 0.5f;
+		noise[i] = rms < 0xff ? rms : 0xff;
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+// get per-sensor health flags
+static uint_fast8_t
+_health_flags(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	uint8_t *flags = NULL;
+	size = CONFIG_SUCCESS("isB", uuid, path, sizeof(health_flags), &flags);
+	memcpy(flags, health_flags, sizeof(health_flags));
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+// get number of stuck, saturated and noisy sensors
+static uint_fast8_t
+_health_status(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	(void)fmt;
+	(void)argc;
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+	int32_t stuck = 0;
+	int32_t saturated = 0;
+	int32_t noisy = 0;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	uint_fast8_t i;
+	for(i=0; i<SENSOR_N; i++)
+	{
+		if(health_flags[i] & HEALTH_STUCK)
+			stuck++;
+		if(health_flags[i] & HEALTH_SATURATED)
+			saturated++;
+		if(health_flags[i] & HEALTH_NOISY)
+			noisy++;
+	}
+
+	size = CONFIG_SUCCESS("isiii", uuid, path, stuck, saturated, noisy);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_sensors_pipelined(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.sensors.pipelined); // applied by loop while DMA is idle
+}
+
+static uint_fast8_t
+_sensors_prediction(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.sensors.prediction);
+	cmc_prediction_update(config.sensors.prediction);
+	return res;
+}
+
 static uint_fast8_t
 _group_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
@@ -414,6 +783,10 @@ static const OSC_Query_Argument sensors_movingaverage_args [] = {
 	OSC_QUERY_ARGUMENT_INT32_VALUES("Sample window", OSC_QUERY_MODE_RW, sensors_movingaverage_windows_values)
 };
 
+static const OSC_Query_Argument sensors_smoothing_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Coefficient", OSC_QUERY_MODE_RW, 0.f, 0.99997f, 0.f)
+};
+
 static const OSC_Query_Argument sensors_interpolation_args [] = {
 	OSC_QUERY_ARGUMENT_STRING_VALUES("Order", OSC_QUERY_MODE_RW, interpolation_mode_args_values)
 };
@@ -422,13 +795,105 @@ static const OSC_Query_Argument sensors_velocity_stiffness_args [] = {
 	OSC_QUERY_ARGUMENT_INT32("Stiffness", OSC_QUERY_MODE_RW, 1, 128, 1)
 };
 
+static const OSC_Query_Argument sensors_prediction_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
+};
+
+static const OSC_Query_Argument governor_enabled_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
+};
+
+static const OSC_Query_Argument governor_min_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Hz", OSC_QUERY_MODE_RW, 25, 10000, 25)
+};
+
+static const OSC_Query_Argument governor_effective_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Hz", OSC_QUERY_MODE_R, 0, 10000, 1)
+};
+
+static const OSC_Query_Item governor_tree [] = {
+	OSC_QUERY_ITEM_METHOD("enabled", "Enable", _governor_enabled, governor_enabled_args),
+	OSC_QUERY_ITEM_METHOD("min", "Minimal update rate when idle", _governor_min, governor_min_args),
+	OSC_QUERY_ITEM_METHOD("effective", "Current update rate", _governor_effective, governor_effective_args)
+};
+
+static const OSC_Query_Value sensors_oversampling_values [] = {
+	{ .i = 1 },
+	{ .i = 2 },
+	{ .i = 4 }
+};
+
+static const OSC_Query_Argument sensors_oversampling_args [] = {
+	OSC_QUERY_ARGUMENT_INT32_VALUES("Conversions per mux step", OSC_QUERY_MODE_RW, sensors_oversampling_values)
+};
+
+static const OSC_Query_Argument sensors_sweep_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("us", OSC_QUERY_MODE_R, 0, 100000, 1)
+};
+
+static const OSC_Query_Argument roi_enabled_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
+};
+
+static const OSC_Query_Argument roi_interval_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Frames", OSC_QUERY_MODE_RW, 1, 255, 1)
+};
+
+static const OSC_Query_Item roi_tree [] = {
+	OSC_QUERY_ITEM_METHOD("enabled", "Enable", _roi_enabled, roi_enabled_args),
+	OSC_QUERY_ITEM_METHOD("interval", "Frames per full sweep", _roi_interval, roi_interval_args)
+};
+
+static const OSC_Query_Argument health_enabled_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
+};
+
+static const OSC_Query_Argument health_feed_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
+};
+
+static const OSC_Query_Argument health_bound_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("LSB", OSC_QUERY_MODE_RW, 0.f, 4096.f, 0.0625f)
+};
+
+static const OSC_Query_Argument health_blob_args [] = {
+	OSC_QUERY_ARGUMENT_BLOB("Blob", OSC_QUERY_MODE_R)
+};
+
+static const OSC_Query_Argument health_status_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Stuck", OSC_QUERY_MODE_R, 0, SENSOR_N, 1),
+	OSC_QUERY_ARGUMENT_INT32("Saturated", OSC_QUERY_MODE_R, 0, SENSOR_N, 1),
+	OSC_QUERY_ARGUMENT_INT32("Noisy", OSC_QUERY_MODE_R, 0, SENSOR_N, 1)
+};
+
+static const OSC_Query_Item health_tree [] = {
+	OSC_QUERY_ITEM_METHOD("enabled", "Enable", _health_enabled, health_enabled_args),
+	OSC_QUERY_ITEM_METHOD("feed", "Raise thresholds above noise floor", _health_feed, health_feed_args),
+	OSC_QUERY_ITEM_METHOD("bound", "RMS noise bound", _health_bound, health_bound_args),
+	OSC_QUERY_ITEM_METHOD("noise", "Query RMS noise in 1/16 LSB", _health_noise, health_blob_args),
+	OSC_QUERY_ITEM_METHOD("flags", "Query stuck(1), saturated(2) and noisy(4) flags", _health_flags, health_blob_args),
+	OSC_QUERY_ITEM_METHOD("status", "Query number of stuck, saturated and noisy sensors", _health_status, health_status_args)
+};
+
+static const OSC_Query_Argument sensors_pipelined_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
+};
+
 const OSC_Query_Item sensors_tree [] = {
 	OSC_QUERY_ITEM_NODE("group/", "Group", group_tree),
 
 	OSC_QUERY_ITEM_METHOD("movingaverage", "Movingaverager", _sensors_movingaverage, sensors_movingaverage_args),
+	OSC_QUERY_ITEM_METHOD("smoothing", "IIR smoothing coefficient of new samples", _sensors_smoothing, sensors_smoothing_args),
 	OSC_QUERY_ITEM_METHOD("interpolation", "Interpolation", _sensors_interpolation, sensors_interpolation_args),
 	OSC_QUERY_ITEM_METHOD("velocity_stiffness", "Stiffness of velocity filter", _sensors_velocity_stiffness, sensors_velocity_stiffness_args),
+	OSC_QUERY_ITEM_METHOD("prediction", "Extrapolate blobs to output offset", _sensors_prediction, sensors_prediction_args),
 	OSC_QUERY_ITEM_METHOD("rate", "Update rate", _sensors_rate, sensors_rate_args),
+	OSC_QUERY_ITEM_NODE("governor/", "Activity-adaptive update rate", governor_tree),
+	OSC_QUERY_ITEM_METHOD("pipelined", "Process frame within its acquisition cycle", _sensors_pipelined, sensors_pipelined_args),
+	OSC_QUERY_ITEM_METHOD("oversampling", "Averaged conversions per mux step", _sensors_oversampling, sensors_oversampling_args),
+	OSC_QUERY_ITEM_METHOD("sweep", "Duration of last mux sweep", _sensors_sweep, sensors_sweep_args),
+	OSC_QUERY_ITEM_NODE("roi/", "Region-of-interest scanning", roi_tree),
+	OSC_QUERY_ITEM_NODE("health/", "Background noise and health statistics", health_tree),
 
 	OSC_QUERY_ITEM_METHOD("number", "Sensor number", _sensors_number, sensors_number_args),
 };
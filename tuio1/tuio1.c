@@ -43,20 +43,36 @@ static char alv_fmt [BLOB_MAX+2] = {
 	OSC_STRING
 }; // this has a variable string len
 
+static OSC_Template frm_tmpl [2];
+static OSC_Template tok_tmpl [2];
+
 static int32_t alv_ids [BLOB_MAX];
-static uint_fast8_t counter;
 
 static osc_data_t *pack;
 static osc_data_t *bndl;
 static osc_data_t *pp;
 
+static void
+tuio1_init(void)
+{
+	uint_fast8_t p;
+	for(p=0; p<2; p++)
+	{
+		osc_template_init(&frm_tmpl[p], profile_str[p], frm_fmt);
+		osc_template_string(&frm_tmpl[p], fseq_str);
+
+		osc_template_init(&tok_tmpl[p], profile_str[p], tok_fmt[p]);
+		osc_template_string(&tok_tmpl[p], set_str);
+	}
+}
+
 static osc_data_t *
 tuio1_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
 	osc_data_t *buf_ptr = buf;
 	osc_data_t *itm;
 
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &pack);
 	buf_ptr = osc_start_bundle(buf_ptr, end, fev->offset, &bndl);
 
@@ -72,12 +88,13 @@ tuio1_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 
 		buf_ptr = osc_set_string(buf_ptr, end, alive_str);
 		pp = buf_ptr;
-		buf_ptr += fev->nblob_new * 4;
+		if(buf_ptr && (buf_ptr + fev->nblob_new*4 <= end) ) // filled in by end_cb
+			buf_ptr += fev->nblob_new * 4;
+		else
+			buf_ptr = NULL;
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 
-	counter = 0; // reset token pointer
-
 	return buf_ptr;
 }
 
@@ -88,21 +105,20 @@ tuio1_engine_end_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 	osc_data_t *itm;
 
 	uint_fast8_t i;
+	cmc_blob_sids(alv_ids); // also lists blobs whose updates were suppressed
 	for(i=0; i<fev->nblob_new; i++)
 		pp = osc_set_int32(pp, end, alv_ids[i]);
 
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, profile_str[config.tuio1.custom_profile]);
-		buf_ptr = osc_set_fmt(buf_ptr, end, frm_fmt);
+		buf_ptr = osc_set_template(buf_ptr, end, &frm_tmpl[config.tuio1.custom_profile]);
 
-		buf_ptr = osc_set_string(buf_ptr, end, fseq_str);
-		buf_ptr = osc_set_int32(buf_ptr, end, fev->fid);
+		buf_ptr = osc_put_int32(buf_ptr, fev->fid);
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 
 	buf_ptr = osc_end_bundle(buf_ptr, end, bndl);
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_end_bundle_item(buf_ptr, end, pack);
 
 	return buf_ptr;
@@ -116,33 +132,29 @@ tuio1_engine_token_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, profile_str[config.tuio1.custom_profile]);
-		buf_ptr = osc_set_fmt(buf_ptr, end, tok_fmt[config.tuio1.custom_profile]);
-
-		buf_ptr = osc_set_string(buf_ptr, end, set_str);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->sid);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->gid);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->x);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->y);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->pid == CMC_NORTH ? 0.f : M_PI);
+		buf_ptr = osc_set_template(buf_ptr, end, &tok_tmpl[config.tuio1.custom_profile]);
+
+		buf_ptr = osc_put_int32(buf_ptr, bev->sid);
+		buf_ptr = osc_put_int32(buf_ptr, bev->gid);
+		buf_ptr = osc_put_float(buf_ptr, bev->x);
+		buf_ptr = osc_put_float(buf_ptr, bev->y);
+		buf_ptr = osc_put_float(buf_ptr, bev->pid == CMC_NORTH ? 0.f : M_PI);
 		if(!config.tuio1.custom_profile)
 		{
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vx); // X
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vy); // Y
-			buf_ptr = osc_set_float(buf_ptr, end, 0.f); // A
-			buf_ptr = osc_set_float(buf_ptr, end, bev->m); // m
-			buf_ptr = osc_set_float(buf_ptr, end, 0.f); // r
+			buf_ptr = osc_put_float(buf_ptr, bev->vx); // X
+			buf_ptr = osc_put_float(buf_ptr, bev->vy); // Y
+			buf_ptr = osc_put_float(buf_ptr, 0.f); // A
+			buf_ptr = osc_put_float(buf_ptr, bev->m); // m
+			buf_ptr = osc_put_float(buf_ptr, 0.f); // r
 		}
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 
-	alv_ids[counter++] = bev->sid;
-
 	return buf_ptr;
 }
 
 CMC_Engine tuio1_engine = {
-	NULL,
+	tuio1_init,
 	tuio1_engine_frame_cb,
 	tuio1_engine_token_cb,
 	NULL,
@@ -162,10 +174,32 @@ _tuio1_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t
 	return res;
 }
 
+static uint_fast8_t
+_tuio1_deltas(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.tuio1.deltas);
+}
+
+static uint_fast8_t
+_tuio1_decimation(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint8(path, fmt, argc, buf, &config.tuio1.decimation);
+}
+
+static uint_fast8_t
+_tuio1_destination(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.tuio1.destination);
+	cmc_engines_update();
+	return res;
+}
+
 static uint_fast8_t
 _tuio1_custom_profile(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
-	return config_check_bool(path, fmt, argc, buf, &config.tuio1.custom_profile);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.tuio1.custom_profile);
+	cmc_engines_resize();
+	return res;
 }
 
 /*
@@ -175,5 +209,8 @@ _tuio1_custom_profile(const char *path, const char *fmt, uint_fast8_t argc, osc_
 const OSC_Query_Item tuio1_tree [] = {
 	// read-write
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _tuio1_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("deltas", "Only send changed blobs", _tuio1_deltas, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("decimation", "Update blobs every Nth frame", _tuio1_decimation, config_decimation_args),
+	OSC_QUERY_ITEM_METHOD("destination", "Output destination", _tuio1_destination, config_destination_args),
 	OSC_QUERY_ITEM_METHOD("custom_profile", "Toggle custom profile", _tuio1_custom_profile, config_boolean_args),
 };
@@ -36,8 +36,10 @@ static const char *tok_fmt [2] = {
 };
 static char alv_fmt [BLOB_MAX+1]; // this has a variable string len
 
+static OSC_Template frm_tmpl;
+static OSC_Template tok_tmpl [2];
+
 static int32_t alv_ids [BLOB_MAX];
-static uint_fast8_t counter;
 
 static const uint32_t dim = (SENSOR_N << 16) | 1;
 static char source [NAME_LENGTH + 9];
@@ -50,6 +52,10 @@ tuio2_init(void)
 {
 	sprintf(source, "%s:0@0x%02x%02x%02x%02x", config.name,
 		config.comm.ip[0], config.comm.ip[1], config.comm.ip[2], config.comm.ip[3]); //FIXME this needs to be updated
+
+	osc_template_init(&frm_tmpl, frm_str, frm_fmt);
+	osc_template_init(&tok_tmpl[0], tok_str, tok_fmt[0]);
+	osc_template_init(&tok_tmpl[1], tok_str, tok_fmt[1]);
 }
 
 static osc_data_t *
@@ -58,35 +64,32 @@ tuio2_engine_frame_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 	osc_data_t *buf_ptr = buf;
 	osc_data_t *itm;
 
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_start_bundle_item(buf_ptr, end, &pack);
 	buf_ptr = osc_start_bundle(buf_ptr, end, fev->offset, &bndl);
 
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, frm_str);
-		buf_ptr = osc_set_fmt(buf_ptr, end, frm_fmt);
+		buf_ptr = osc_set_template(buf_ptr, end, &frm_tmpl);
 
-		buf_ptr = osc_set_int32(buf_ptr, end, fev->fid);
+		buf_ptr = osc_put_int32(buf_ptr, fev->fid);
 		buf_ptr = osc_set_timetag(buf_ptr, end, fev->now);
-		buf_ptr = osc_set_int32(buf_ptr, end, dim);
+		buf_ptr = osc_put_int32(buf_ptr, dim);
 		buf_ptr = osc_set_string(buf_ptr, end, source);
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 
-	counter = 0; // reset token pointer
-
 	return buf_ptr;
 }
 
 static osc_data_t *
 tuio2_engine_end_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 {
-	(void)fev;
 	osc_data_t *buf_ptr = buf;
 	osc_data_t *itm;
 
 	uint_fast8_t i;
+	uint_fast8_t counter = cmc_blob_sids(alv_ids); // also lists blobs whose updates were suppressed
 	for(i=0; i<counter; i++)
 		alv_fmt[i] = OSC_INT32;
 	alv_fmt[counter] = '\0';
@@ -102,7 +105,7 @@ tuio2_engine_end_cb(osc_data_t *buf, osc_data_t *end, CMC_Frame_Event *fev)
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 
 	buf_ptr = osc_end_bundle(buf_ptr, end, bndl);
-	if(cmc_engines_active + config.dump.enabled > 1)
+	if(fev->nested)
 		buf_ptr = osc_end_bundle_item(buf_ptr, end, pack);
 
 	return buf_ptr;
@@ -116,29 +119,26 @@ tuio2_engine_token_cb(osc_data_t *buf, osc_data_t *end, CMC_Blob_Event *bev)
 
 	buf_ptr = osc_start_bundle_item(buf_ptr, end, &itm);
 	{
-		buf_ptr = osc_set_path(buf_ptr, end, tok_str);
-		buf_ptr = osc_set_fmt(buf_ptr, end, tok_fmt[config.tuio2.derivatives]);
+		buf_ptr = osc_set_template(buf_ptr, end, &tok_tmpl[config.tuio2.derivatives]);
 
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->sid);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->pid);
-		buf_ptr = osc_set_int32(buf_ptr, end, bev->gid);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->x);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->y);
-		buf_ptr = osc_set_float(buf_ptr, end, bev->pid == CMC_NORTH ? 0.f : M_PI);
+		buf_ptr = osc_put_int32(buf_ptr, bev->sid);
+		buf_ptr = osc_put_int32(buf_ptr, bev->pid);
+		buf_ptr = osc_put_int32(buf_ptr, bev->gid);
+		buf_ptr = osc_put_float(buf_ptr, bev->x);
+		buf_ptr = osc_put_float(buf_ptr, bev->y);
+		buf_ptr = osc_put_float(buf_ptr, bev->pid == CMC_NORTH ? 0.f : M_PI);
 
 		if(config.tuio2.derivatives)
 		{
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vx);
-			buf_ptr = osc_set_float(buf_ptr, end, bev->vy);
-			buf_ptr = osc_set_float(buf_ptr, end, 0.f); // angular velocity
-			buf_ptr = osc_set_float(buf_ptr, end, bev->m); // acceleration
-			buf_ptr = osc_set_float(buf_ptr, end, 0.f); // angular acceleration
+			buf_ptr = osc_put_float(buf_ptr, bev->vx);
+			buf_ptr = osc_put_float(buf_ptr, bev->vy);
+			buf_ptr = osc_put_float(buf_ptr, 0.f); // angular velocity
+			buf_ptr = osc_put_float(buf_ptr, bev->m); // acceleration
+			buf_ptr = osc_put_float(buf_ptr, 0.f); // angular acceleration
 		}
 	}
 	buf_ptr = osc_end_bundle_item(buf_ptr, end, itm);
 
-	alv_ids[counter++] = bev->sid;
-
 	return buf_ptr;
 }
 
@@ -162,10 +162,32 @@ _tuio2_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t
 	return res;
 }
 
+static uint_fast8_t
+_tuio2_deltas(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.tuio2.deltas);
+}
+
+static uint_fast8_t
+_tuio2_decimation(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_uint8(path, fmt, argc, buf, &config.tuio2.decimation);
+}
+
+static uint_fast8_t
+_tuio2_destination(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.tuio2.destination);
+	cmc_engines_update();
+	return res;
+}
+
 static uint_fast8_t
 _tuio2_derivatives(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
-	return config_check_bool(path, fmt, argc, buf, &config.tuio2.derivatives);
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.tuio2.derivatives);
+	cmc_engines_resize();
+	return res;
 }
 
 /*
@@ -174,5 +196,8 @@ _tuio2_derivatives(const char *path, const char *fmt, uint_fast8_t argc, osc_dat
 
 const OSC_Query_Item tuio2_tree [] = {
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _tuio2_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("deltas", "Only send changed blobs", _tuio2_deltas, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("decimation", "Update blobs every Nth frame", _tuio2_decimation, config_decimation_args),
+	OSC_QUERY_ITEM_METHOD("destination", "Output destination", _tuio2_destination, config_destination_args),
 	OSC_QUERY_ITEM_METHOD("derivatives", "Calculate derivatives", _tuio2_derivatives, config_boolean_args),
 };